@@ -9,6 +9,41 @@
 #define mmGENERIC_I2C_TRANSACTION                                                       0x16f9
 #define mmGENERIC_I2C_DATA                                                              0x16fa
 #define mmGENERIC_I2C_PIN_SELECTION                                                     0x16fb
+#define mmDC_I2C_ARBITRATION                                                            0x16d5
+#define mmDC_I2C_SW_STATUS                                                              0x16d7
+#define mmDC_I2C_CONTROL                                                                0x16d4
+#define mmDC_I2C_DDC1_HW_STATUS                                                         0x16d8
+#define mmDC_I2C_DDC2_HW_STATUS                                                         0x16d9
+#define mmDC_I2C_DDC3_HW_STATUS                                                         0x16da
+#define mmDC_I2C_DDC4_HW_STATUS                                                         0x16db
+#define mmDC_I2C_DDC5_HW_STATUS                                                         0x16dc
+#define mmDC_I2C_DDC6_HW_STATUS                                                         0x16dd
+#define mmDC_I2C_DDC1_SPEED                                                             0x16de
+#define mmDC_I2C_DDC1_SETUP                                                             0x16df
+#define mmDC_I2C_DDC2_SPEED                                                             0x16e0
+#define mmDC_I2C_DDC2_SETUP                                                             0x16e1
+#define mmDC_I2C_DDC3_SPEED                                                             0x16e2
+#define mmDC_I2C_DDC3_SETUP                                                             0x16e3
+#define mmDC_I2C_DDC4_SPEED                                                             0x16e4
+#define mmDC_I2C_DDC4_SETUP                                                             0x16e5
+#define mmDC_I2C_DDC5_SPEED                                                             0x16e6
+#define mmDC_I2C_DDC5_SETUP                                                             0x16e7
+#define mmDC_I2C_DDC6_SPEED                                                             0x16e8
+#define mmDC_I2C_DDC6_SETUP                                                             0x16e9
+#define mmDC_I2C_TRANSACTION0                                                           0x16ea
+#define mmDC_I2C_TRANSACTION1                                                           0x16eb
+#define mmDC_I2C_TRANSACTION2                                                           0x16ec
+#define mmDC_I2C_TRANSACTION3                                                           0x16ed
+#define mmDC_I2C_DATA                                                                   0x16ee
+#define mmDC_I2C_DDCVGA_HW_STATUS                                                       0x16ef
+#define mmDC_I2C_DDCVGA_SPEED                                                           0x16f0
+#define mmDC_I2C_DDCVGA_SETUP                                                           0x16f1
+#define mmDC_GPIO_DDC1_A                                                                0x4869
+#define mmDC_GPIO_DDC2_A                                                                0x486d
+#define mmDC_GPIO_DDC3_A                                                                0x4871
+#define mmDC_GPIO_DDC4_A                                                                0x4875
+#define mmDC_GPIO_DDC5_A                                                                0x4879
+#define mmDC_GPIO_DDC6_A                                                                0x487d
 
 #define GENERIC_I2C_CONTROL__GENERIC_I2C_GO_MASK                                        0x1
 #define GENERIC_I2C_CONTROL__GENERIC_I2C_GO__SHIFT                                      0x0
@@ -90,17 +125,94 @@
 #define GENERIC_I2C_PIN_SELECTION__GENERIC_I2C_SCL_PIN_SEL__SHIFT                       0x0
 #define GENERIC_I2C_PIN_SELECTION__GENERIC_I2C_SDA_PIN_SEL_MASK                         0x7f00
 #define GENERIC_I2C_PIN_SELECTION__GENERIC_I2C_SDA_PIN_SEL__SHIFT                       0x8
+#define DC_I2C_ARBITRATION__DC_I2C_SW_USE_I2C_REG_REQ_MASK                              0x100000
+#define DC_I2C_ARBITRATION__DC_I2C_SW_USE_I2C_REG_REQ__SHIFT                            0x14
+#define DC_I2C_ARBITRATION__DC_I2C_SW_DONE_USING_I2C_REG_MASK                           0x200000
+#define DC_I2C_ARBITRATION__DC_I2C_SW_DONE_USING_I2C_REG__SHIFT                         0x15
+#define DC_I2C_ARBITRATION__DC_I2C_REG_RW_CNTL_STATUS_MASK                              0x30000000
+#define DC_I2C_ARBITRATION__DC_I2C_REG_RW_CNTL_STATUS__SHIFT                            0x1c
+#define DC_I2C_SW_STATUS__DC_I2C_SW_STATUS_MASK                                         0x3
+#define DC_I2C_SW_STATUS__DC_I2C_SW_STATUS__SHIFT                                       0x0
+
+#define DC_I2C_CONTROL__DC_I2C_GO_MASK                                                  0x1
+#define DC_I2C_CONTROL__DC_I2C_GO__SHIFT                                                0x0
+#define DC_I2C_CONTROL__DC_I2C_SOFT_RESET_MASK                                          0x2
+#define DC_I2C_CONTROL__DC_I2C_SOFT_RESET__SHIFT                                        0x1
+#define DC_I2C_CONTROL__DC_I2C_SEND_RESET_MASK                                          0x4
+#define DC_I2C_CONTROL__DC_I2C_SEND_RESET__SHIFT                                        0x2
+#define DC_I2C_CONTROL__DC_I2C_SW_STATUS_RESET_MASK                                     0x8
+#define DC_I2C_CONTROL__DC_I2C_SW_STATUS_RESET__SHIFT                                   0x3
+#define DC_I2C_CONTROL__DC_I2C_DDC_SELECT_MASK                                          0x700
+#define DC_I2C_CONTROL__DC_I2C_DDC_SELECT__SHIFT                                        0x8
+#define DC_I2C_CONTROL__DC_I2C_TRANSACTION_COUNT_MASK                                   0x300000
+#define DC_I2C_CONTROL__DC_I2C_TRANSACTION_COUNT__SHIFT                                 0x14
+#define DC_I2C_ARBITRATION__DC_I2C_NO_QUEUED_SW_GO_MASK                                 0x200
+#define DC_I2C_ARBITRATION__DC_I2C_NO_QUEUED_SW_GO__SHIFT                               0x9
+#define DC_I2C_SW_STATUS__DC_I2C_SW_DONE_MASK                                           0x4
+#define DC_I2C_SW_STATUS__DC_I2C_SW_DONE__SHIFT                                         0x2
+#define DC_I2C_SW_STATUS__DC_I2C_SW_ABORTED_MASK                                        0x10
+#define DC_I2C_SW_STATUS__DC_I2C_SW_ABORTED__SHIFT                                      0x4
+#define DC_I2C_SW_STATUS__DC_I2C_SW_TIMEOUT_MASK                                        0x20
+#define DC_I2C_SW_STATUS__DC_I2C_SW_TIMEOUT__SHIFT                                      0x5
+#define DC_I2C_SW_STATUS__DC_I2C_SW_STOPPED_ON_NACK_MASK                                0x100
+#define DC_I2C_SW_STATUS__DC_I2C_SW_STOPPED_ON_NACK__SHIFT                              0x8
+#define DC_I2C_DDC1_HW_STATUS__DC_I2C_DDC1_HW_STATUS_MASK                               0x3
+#define DC_I2C_DDC1_HW_STATUS__DC_I2C_DDC1_HW_STATUS__SHIFT                             0x0
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_THRESHOLD_MASK                                   0x3
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_THRESHOLD__SHIFT                                 0x0
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_START_STOP_TIMING_CNTL_MASK                      0x300
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_START_STOP_TIMING_CNTL__SHIFT                    0x8
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_PRESCALE_MASK                                    0xffff0000
+#define DC_I2C_DDC1_SPEED__DC_I2C_DDC1_PRESCALE__SHIFT                                  0x10
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_DATA_DRIVE_EN_MASK                               0x1
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_DATA_DRIVE_EN__SHIFT                             0x0
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_DATA_DRIVE_SEL_MASK                              0x2
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_DATA_DRIVE_SEL__SHIFT                            0x1
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_ENABLE_MASK                                      0x40
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_ENABLE__SHIFT                                    0x6
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_CLK_DRIVE_EN_MASK                                0x80
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_CLK_DRIVE_EN__SHIFT                              0x7
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_INTRA_BYTE_DELAY_MASK                            0xff00
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_INTRA_BYTE_DELAY__SHIFT                          0x8
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_INTRA_TRANSACTION_DELAY_MASK                     0xff0000
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_INTRA_TRANSACTION_DELAY__SHIFT                   0x10
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_TIME_LIMIT_MASK                                  0xff000000
+#define DC_I2C_DDC1_SETUP__DC_I2C_DDC1_TIME_LIMIT__SHIFT                                0x18
+#define DC_I2C_TRANSACTION0__DC_I2C_RW0_MASK                                            0x1
+#define DC_I2C_TRANSACTION0__DC_I2C_RW0__SHIFT                                          0x0
+#define DC_I2C_TRANSACTION0__DC_I2C_STOP_ON_NACK0_MASK                                  0x100
+#define DC_I2C_TRANSACTION0__DC_I2C_STOP_ON_NACK0__SHIFT                                0x8
+#define DC_I2C_TRANSACTION0__DC_I2C_ACK_ON_READ0_MASK                                   0x200
+#define DC_I2C_TRANSACTION0__DC_I2C_ACK_ON_READ0__SHIFT                                 0x9
+#define DC_I2C_TRANSACTION0__DC_I2C_START0_MASK                                         0x1000
+#define DC_I2C_TRANSACTION0__DC_I2C_START0__SHIFT                                       0xc
+#define DC_I2C_TRANSACTION0__DC_I2C_STOP0_MASK                                          0x2000
+#define DC_I2C_TRANSACTION0__DC_I2C_STOP0__SHIFT                                        0xd
+#define DC_I2C_TRANSACTION0__DC_I2C_COUNT0_MASK                                         0xff0000
+#define DC_I2C_TRANSACTION0__DC_I2C_COUNT0__SHIFT                                       0x10
+#define DC_I2C_DATA__DC_I2C_DATA_RW_MASK                                                0x1
+#define DC_I2C_DATA__DC_I2C_DATA_RW__SHIFT                                              0x0
+#define DC_I2C_DATA__DC_I2C_DATA_MASK                                                   0xff00
+#define DC_I2C_DATA__DC_I2C_DATA__SHIFT                                                 0x8
+#define DC_I2C_DATA__DC_I2C_INDEX_MASK                                                  0xff0000
+#define DC_I2C_DATA__DC_I2C_INDEX__SHIFT                                                0x10
+#define DC_I2C_DATA__DC_I2C_INDEX_WRITE_MASK                                            0x80000000
+#define DC_I2C_DATA__DC_I2C_INDEX_WRITE__SHIFT                                          0x1f
 
 static const struct i2c_registers i2c_registers = {
-    I2C_GENERIC_REG_LIST()
+    I2C_GENERIC_REG_LIST(),
+    I2C_DDC_REG_LIST(),
+    SR_GPIO_DDC_A()
 };
 
 static const struct i2c_mask i2c_masks = {
     I2C_GENERIC_MASK_SH_LIST(_MASK)
+    I2C_DDC_MASK_SH_LIST(_MASK)
 };
 
 static const struct i2c_shift i2c_shifts = {
     I2C_GENERIC_MASK_SH_LIST(__SHIFT)
+    I2C_DDC_MASK_SH_LIST(__SHIFT)
 };
 
 const struct asic_context asic_context_polaris = {
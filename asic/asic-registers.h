@@ -6,6 +6,29 @@
 
 #define SR(reg_name) .reg_name = mm ## reg_name
 
+/* DDC1 to DDC6, then DDCVGA */
+#define DC_I2C_DDC_COUNT            7
+#define DC_I2C_MAX_TRANSACTIONS     4
+
+enum aura_i2c_status {
+    DC_I2C_STATUS__DC_I2C_STATUS_IDLE,
+    DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_SW,
+    DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_HW,
+    DC_I2C_REG_RW_CNTL_STATUS_DMCU_ONLY = 2,
+};
+
+/* Each DDC channel has its own copy, all sharing the DDC1 layout */
+#define SR_DDC(reg_name)\
+    .DC_I2C_DDC_ ## reg_name = {\
+        mmDC_I2C_DDC1_ ## reg_name,\
+        mmDC_I2C_DDC2_ ## reg_name,\
+        mmDC_I2C_DDC3_ ## reg_name,\
+        mmDC_I2C_DDC4_ ## reg_name,\
+        mmDC_I2C_DDC5_ ## reg_name,\
+        mmDC_I2C_DDC6_ ## reg_name,\
+        mmDC_I2C_DDCVGA_ ## reg_name,\
+    }
+
 #define I2C_GENERIC_REG_LIST()\
     SR(GENERIC_I2C_CONTROL),\
     SR(GENERIC_I2C_INTERRUPT_CONTROL),\
@@ -14,7 +37,36 @@
     SR(GENERIC_I2C_SETUP),\
     SR(GENERIC_I2C_TRANSACTION),\
     SR(GENERIC_I2C_DATA),\
-    SR(GENERIC_I2C_PIN_SELECTION)
+    SR(GENERIC_I2C_PIN_SELECTION),\
+    SR(DC_I2C_ARBITRATION),\
+    SR(DC_I2C_SW_STATUS)
+
+/*
+ * DC_GPIO_DDCx_A of each channel, which the display core matches against
+ * a line's clock register to find its DDC channel. Zero where unknown.
+ */
+#define SR_GPIO_DDC_A()\
+    .DC_GPIO_DDC_A = {\
+        mmDC_GPIO_DDC1_A,\
+        mmDC_GPIO_DDC2_A,\
+        mmDC_GPIO_DDC3_A,\
+        mmDC_GPIO_DDC4_A,\
+        mmDC_GPIO_DDC5_A,\
+        mmDC_GPIO_DDC6_A,\
+    }
+
+#define I2C_DDC_REG_LIST()\
+    SR(DC_I2C_CONTROL),\
+    SR(DC_I2C_DATA),\
+    .DC_I2C_TRANSACTION = {\
+        mmDC_I2C_TRANSACTION0,\
+        mmDC_I2C_TRANSACTION1,\
+        mmDC_I2C_TRANSACTION2,\
+        mmDC_I2C_TRANSACTION3,\
+    },\
+    SR_DDC(HW_STATUS),\
+    SR_DDC(SPEED),\
+    SR_DDC(SETUP)
 
 #define I2C_SF(reg_name, field_name, post_fix)\
 	.field_name = reg_name ## __ ## field_name ## post_fix
@@ -54,6 +106,45 @@
     I2C_SF(GENERIC_I2C_INTERRUPT_CONTROL, GENERIC_I2C_DONE_INT, mask_sh),\
     I2C_SF(GENERIC_I2C_INTERRUPT_CONTROL, GENERIC_I2C_DONE_ACK, mask_sh),\
     I2C_SF(GENERIC_I2C_INTERRUPT_CONTROL, GENERIC_I2C_DONE_MASK, mask_sh),\
+    I2C_SF(DC_I2C_ARBITRATION, DC_I2C_SW_USE_I2C_REG_REQ, mask_sh),\
+    I2C_SF(DC_I2C_ARBITRATION, DC_I2C_SW_DONE_USING_I2C_REG, mask_sh),\
+    I2C_SF(DC_I2C_ARBITRATION, DC_I2C_REG_RW_CNTL_STATUS, mask_sh),\
+    I2C_SF(DC_I2C_SW_STATUS, DC_I2C_SW_STATUS, mask_sh),\
+
+/* Transactions 1 to 3 share the layout of transaction 0 */
+#define I2C_DDC_MASK_SH_LIST(mask_sh)\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_GO, mask_sh),\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_SOFT_RESET, mask_sh),\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_SEND_RESET, mask_sh),\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_SW_STATUS_RESET, mask_sh),\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_DDC_SELECT, mask_sh),\
+    I2C_SF(DC_I2C_CONTROL, DC_I2C_TRANSACTION_COUNT, mask_sh),\
+    I2C_SF(DC_I2C_ARBITRATION, DC_I2C_NO_QUEUED_SW_GO, mask_sh),\
+    I2C_SF(DC_I2C_SW_STATUS, DC_I2C_SW_DONE, mask_sh),\
+    I2C_SF(DC_I2C_SW_STATUS, DC_I2C_SW_ABORTED, mask_sh),\
+    I2C_SF(DC_I2C_SW_STATUS, DC_I2C_SW_TIMEOUT, mask_sh),\
+    I2C_SF(DC_I2C_SW_STATUS, DC_I2C_SW_STOPPED_ON_NACK, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_HW_STATUS, DC_I2C_DDC1_HW_STATUS, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SPEED, DC_I2C_DDC1_THRESHOLD, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SPEED, DC_I2C_DDC1_START_STOP_TIMING_CNTL, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SPEED, DC_I2C_DDC1_PRESCALE, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_DATA_DRIVE_EN, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_DATA_DRIVE_SEL, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_ENABLE, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_CLK_DRIVE_EN, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_INTRA_BYTE_DELAY, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_INTRA_TRANSACTION_DELAY, mask_sh),\
+    I2C_SF(DC_I2C_DDC1_SETUP, DC_I2C_DDC1_TIME_LIMIT, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_RW0, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_STOP_ON_NACK0, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_ACK_ON_READ0, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_START0, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_STOP0, mask_sh),\
+    I2C_SF(DC_I2C_TRANSACTION0, DC_I2C_COUNT0, mask_sh),\
+    I2C_SF(DC_I2C_DATA, DC_I2C_DATA_RW, mask_sh),\
+    I2C_SF(DC_I2C_DATA, DC_I2C_DATA, mask_sh),\
+    I2C_SF(DC_I2C_DATA, DC_I2C_INDEX, mask_sh),\
+    I2C_SF(DC_I2C_DATA, DC_I2C_INDEX_WRITE, mask_sh),\
 
 struct i2c_registers {
 	uint32_t GENERIC_I2C_SETUP;
@@ -64,6 +155,15 @@ struct i2c_registers {
 	uint32_t GENERIC_I2C_DATA;
 	uint32_t GENERIC_I2C_INTERRUPT_CONTROL;
 	uint32_t GENERIC_I2C_PIN_SELECTION;
+	uint32_t DC_I2C_ARBITRATION;
+	uint32_t DC_I2C_SW_STATUS;
+	uint32_t DC_I2C_CONTROL;
+	uint32_t DC_I2C_DATA;
+	uint32_t DC_I2C_TRANSACTION[DC_I2C_MAX_TRANSACTIONS];
+	uint32_t DC_I2C_DDC_HW_STATUS[DC_I2C_DDC_COUNT];
+	uint32_t DC_I2C_DDC_SPEED[DC_I2C_DDC_COUNT];
+	uint32_t DC_I2C_DDC_SETUP[DC_I2C_DDC_COUNT];
+	uint32_t DC_GPIO_DDC_A[DC_I2C_DDC_COUNT];
 };
 
 struct i2c_mask {
@@ -102,6 +202,42 @@ struct i2c_mask {
     uint32_t GENERIC_I2C_DONE_INT;
     uint32_t GENERIC_I2C_DONE_ACK;
     uint32_t GENERIC_I2C_DONE_MASK;
+    uint32_t DC_I2C_SW_USE_I2C_REG_REQ;
+    uint32_t DC_I2C_SW_DONE_USING_I2C_REG;
+    uint32_t DC_I2C_REG_RW_CNTL_STATUS;
+    uint32_t DC_I2C_SW_STATUS;
+    uint32_t DC_I2C_GO;
+    uint32_t DC_I2C_SOFT_RESET;
+    uint32_t DC_I2C_SEND_RESET;
+    uint32_t DC_I2C_SW_STATUS_RESET;
+    uint32_t DC_I2C_DDC_SELECT;
+    uint32_t DC_I2C_TRANSACTION_COUNT;
+    uint32_t DC_I2C_NO_QUEUED_SW_GO;
+    uint32_t DC_I2C_SW_DONE;
+    uint32_t DC_I2C_SW_ABORTED;
+    uint32_t DC_I2C_SW_TIMEOUT;
+    uint32_t DC_I2C_SW_STOPPED_ON_NACK;
+    uint32_t DC_I2C_DDC1_HW_STATUS;
+    uint32_t DC_I2C_DDC1_THRESHOLD;
+    uint32_t DC_I2C_DDC1_START_STOP_TIMING_CNTL;
+    uint32_t DC_I2C_DDC1_PRESCALE;
+    uint32_t DC_I2C_DDC1_DATA_DRIVE_EN;
+    uint32_t DC_I2C_DDC1_DATA_DRIVE_SEL;
+    uint32_t DC_I2C_DDC1_ENABLE;
+    uint32_t DC_I2C_DDC1_CLK_DRIVE_EN;
+    uint32_t DC_I2C_DDC1_INTRA_BYTE_DELAY;
+    uint32_t DC_I2C_DDC1_INTRA_TRANSACTION_DELAY;
+    uint32_t DC_I2C_DDC1_TIME_LIMIT;
+    uint32_t DC_I2C_RW0;
+    uint32_t DC_I2C_STOP_ON_NACK0;
+    uint32_t DC_I2C_ACK_ON_READ0;
+    uint32_t DC_I2C_START0;
+    uint32_t DC_I2C_STOP0;
+    uint32_t DC_I2C_COUNT0;
+    uint32_t DC_I2C_DATA_RW;
+    uint32_t DC_I2C_DATA;
+    uint32_t DC_I2C_INDEX;
+    uint32_t DC_I2C_INDEX_WRITE;
 };
 
 struct i2c_shift {
@@ -140,6 +276,42 @@ struct i2c_shift {
     uint8_t GENERIC_I2C_DONE_INT;
     uint8_t GENERIC_I2C_DONE_ACK;
     uint8_t GENERIC_I2C_DONE_MASK;
+    uint8_t DC_I2C_SW_USE_I2C_REG_REQ;
+    uint8_t DC_I2C_SW_DONE_USING_I2C_REG;
+    uint8_t DC_I2C_REG_RW_CNTL_STATUS;
+    uint8_t DC_I2C_SW_STATUS;
+    uint8_t DC_I2C_GO;
+    uint8_t DC_I2C_SOFT_RESET;
+    uint8_t DC_I2C_SEND_RESET;
+    uint8_t DC_I2C_SW_STATUS_RESET;
+    uint8_t DC_I2C_DDC_SELECT;
+    uint8_t DC_I2C_TRANSACTION_COUNT;
+    uint8_t DC_I2C_NO_QUEUED_SW_GO;
+    uint8_t DC_I2C_SW_DONE;
+    uint8_t DC_I2C_SW_ABORTED;
+    uint8_t DC_I2C_SW_TIMEOUT;
+    uint8_t DC_I2C_SW_STOPPED_ON_NACK;
+    uint8_t DC_I2C_DDC1_HW_STATUS;
+    uint8_t DC_I2C_DDC1_THRESHOLD;
+    uint8_t DC_I2C_DDC1_START_STOP_TIMING_CNTL;
+    uint8_t DC_I2C_DDC1_PRESCALE;
+    uint8_t DC_I2C_DDC1_DATA_DRIVE_EN;
+    uint8_t DC_I2C_DDC1_DATA_DRIVE_SEL;
+    uint8_t DC_I2C_DDC1_ENABLE;
+    uint8_t DC_I2C_DDC1_CLK_DRIVE_EN;
+    uint8_t DC_I2C_DDC1_INTRA_BYTE_DELAY;
+    uint8_t DC_I2C_DDC1_INTRA_TRANSACTION_DELAY;
+    uint8_t DC_I2C_DDC1_TIME_LIMIT;
+    uint8_t DC_I2C_RW0;
+    uint8_t DC_I2C_STOP_ON_NACK0;
+    uint8_t DC_I2C_ACK_ON_READ0;
+    uint8_t DC_I2C_START0;
+    uint8_t DC_I2C_STOP0;
+    uint8_t DC_I2C_COUNT0;
+    uint8_t DC_I2C_DATA_RW;
+    uint8_t DC_I2C_DATA;
+    uint8_t DC_I2C_INDEX;
+    uint8_t DC_I2C_INDEX_WRITE;
 };
 
 struct asic_context {
@@ -23,6 +23,7 @@
  */
 
 #include <linux/delay.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
@@ -33,6 +34,7 @@
 #include "atom.h"
 #include "atom-names.h"
 #include "atom-bits.h"
+#include "../aura-gpu-trace.h"
 
 #define ATOM_COND_ABOVE        0
 #define ATOM_COND_ABOVEOREQUAL 1
@@ -146,6 +148,18 @@ static uint32_t atom_iio_execute(struct atom_context *ctx, int base, uint32_t in
         }
 }
 
+/*
+ * The FB window is only backed by memory once a table writes to it, most
+ * tables never do. Callers hold ctx->mutex.
+ */
+static uint32_t *atom_alloc_scratch(struct atom_context *ctx)
+{
+    if (!ctx->scratch && ctx->scratch_size_bytes > 0)
+        ctx->scratch = kvzalloc(ctx->scratch_size_bytes, GFP_KERNEL);
+
+    return ctx->scratch;
+}
+
 static uint32_t atom_get_src_int(atom_exec_context *ctx, uint8_t attr, int *ptr, uint32_t *saved, int print)
 {
     uint32_t idx, val = 0xCDCDCDCD, align, arg;
@@ -245,10 +259,15 @@ static uint32_t atom_get_src_int(atom_exec_context *ctx, uint8_t attr, int *ptr,
     case ATOM_ARG_FB:
         idx = U8(*ptr);
         (*ptr)++;
-        if ((gctx->fb_base + (idx * 4)) > gctx->scratch_size_bytes) {
+        if (gctx->hooks && gctx->hooks->fb_access)
+            gctx->hooks->fb_access(gctx->hooks, (gctx->fb_base / 4) + idx, false);
+        if ((gctx->fb_base + (idx * 4)) >= gctx->scratch_size_bytes) {
             ADEBUG("ATOM: fb read beyond scratch region: %d vs. %d\n",
                   gctx->fb_base + (idx * 4), gctx->scratch_size_bytes);
             val = 0;
+        } else if (!gctx->scratch) {
+            /* Nothing was written yet, the window reads as zeroes */
+            val = 0;
         } else
             val = gctx->scratch[(gctx->fb_base / 4) + idx];
         if (print)
@@ -491,8 +510,12 @@ static void atom_put_dst(atom_exec_context *ctx, int arg, uint8_t attr, int *ptr
     case ATOM_ARG_FB:
         idx = U8(*ptr);
         (*ptr)++;
-        if ((gctx->fb_base + (idx * 4)) > gctx->scratch_size_bytes) {
+        if (gctx->hooks && gctx->hooks->fb_access)
+            gctx->hooks->fb_access(gctx->hooks, (gctx->fb_base / 4) + idx, true);
+        if ((gctx->fb_base + (idx * 4)) >= gctx->scratch_size_bytes) {
             ADEBUG("ATOM: fb write beyond scratch region: %d vs. %d\n", gctx->fb_base + (idx * 4), gctx->scratch_size_bytes);
+        } else if (!gctx->scratch && !atom_alloc_scratch(gctx)) {
+            ADEBUG("ATOM: fb write dropped, no scratch region\n");
         } else {
             _DEBUG("ATOM: scratch write 0x%x to index %d", val, (gctx->fb_base / 4) + idx);
             gctx->scratch[(gctx->fb_base / 4) + idx] = val;
@@ -617,7 +640,10 @@ static void atom_op_compare(atom_exec_context *ctx, int *ptr, int arg)
 static void atom_op_delay(atom_exec_context *ctx, int *ptr, int arg)
 {
     unsigned count = U8((*ptr)++);
+    struct atom_hooks *hooks = ctx->ctx->hooks;
     SDEBUG("   count: %d\n", count);
+    if (hooks && hooks->delay)
+        hooks->delay(hooks, arg == ATOM_UNIT_MICROSEC ? count : count * 1000);
     if (arg == ATOM_UNIT_MICROSEC)
         udelay(count);
     // else if (!drm_can_sleep())
@@ -1166,6 +1192,7 @@ static int atom_execute_table_locked(struct atom_context *ctx, int index, uint32
     int len, ws, ps, ptr;
     unsigned char op;
     atom_exec_context ectx;
+    bool ws_stacked = false;
     int ret = 0;
 
     if (!base)
@@ -1184,10 +1211,23 @@ static int atom_execute_table_locked(struct atom_context *ctx, int index, uint32
     ectx.ps = params;
     ectx.abort = false;
     ectx.last_jump = 0;
-    if (ws)
-        ectx.ws = kcalloc(4, ws, GFP_KERNEL);
-    else
-        ectx.ws = NULL;
+    ectx.ws = NULL;
+    if (ws) {
+        /* nested calls push onto the preallocated stack, heap only if it runs out */
+        if (ctx->ws_stack && ctx->ws_stack_top + ws <= ctx->ws_stack_size) {
+            ectx.ws = ctx->ws_stack + ctx->ws_stack_top;
+            ctx->ws_stack_top += ws;
+            ws_stacked = true;
+            memset(ectx.ws, 0, ws * 4);
+        } else {
+            ectx.ws = kcalloc(4, ws, GFP_KERNEL);
+            if (!ectx.ws)
+                return -ENOMEM;
+            ctx->ws_heap_allocs++;
+        }
+    }
+
+    trace_aura_atom_table_enter(index, ws, ps);
 
     debug_depth++;
     while (1) {
@@ -1215,16 +1255,17 @@ static int atom_execute_table_locked(struct atom_context *ctx, int index, uint32
     SDEBUG("<<\n");
 
 free:
-    if (ws)
+    if (ws_stacked)
+        ctx->ws_stack_top -= ws;
+    else if (ws)
         kfree(ectx.ws);
+    trace_aura_atom_table_exit(index, ret);
     return ret;
 }
 
-int atom_execute_table(struct atom_context *ctx, int index, uint32_t * params)
+/* Caller must hold ctx->mutex */
+int __atom_execute_table(struct atom_context *ctx, int index, uint32_t * params)
 {
-    int r;
-
-    mutex_lock(&ctx->mutex);
     /* reset data block */
     ctx->data_block = 0;
     /* reset reg block */
@@ -1236,11 +1277,43 @@ int atom_execute_table(struct atom_context *ctx, int index, uint32_t * params)
     /* reset divmul */
     ctx->divmul[0] = 0;
     ctx->divmul[1] = 0;
-    r = atom_execute_table_locked(ctx, index, params);
+    /* reset ws stack */
+    ctx->ws_stack_top = 0;
+    return atom_execute_table_locked(ctx, index, params);
+}
+
+int atom_execute_table(struct atom_context *ctx, int index, uint32_t * params)
+{
+    int r;
+
+    mutex_lock(&ctx->mutex);
+    r = __atom_execute_table(ctx, index, params);
     mutex_unlock(&ctx->mutex);
     return r;
 }
 
+static void atom_alloc_ws_stack(struct atom_context *ctx)
+{
+    int count = (CU16(ctx->cmd_table + ATOM_CT_SIZE_PTR) - 4) / 2;
+    int idx, base, ws, max_ws = 0;
+
+    for (idx = 0; idx < count; idx++) {
+        base = CU16(ctx->cmd_table + 4 + 2 * idx);
+        if (!base)
+            continue;
+        ws = CU8(base + ATOM_CT_WS_PTR);
+        if (ws > max_ws)
+            max_ws = ws;
+    }
+
+    if (!max_ws)
+        return;
+
+    ctx->ws_stack = kcalloc(max_ws * ATOM_WS_STACK_DEPTH, 4, GFP_KERNEL);
+    if (ctx->ws_stack)
+        ctx->ws_stack_size = max_ws * ATOM_WS_STACK_DEPTH;
+}
+
 static int atom_iio_len[] = { 1, 2, 3, 3, 3, 3, 4, 4, 4, 3 };
 
 static void atom_index_iio(struct atom_context *ctx, int base)
@@ -1298,6 +1371,8 @@ struct atom_context *atom_parse(struct card_info *card, void const *bios)
         return NULL;
     }
 
+    atom_alloc_ws_stack(ctx);
+
     idx = CU16(ATOM_ROM_PART_NUMBER_PTR);
     if (idx == 0)
         idx = 0x80;
@@ -1337,6 +1412,8 @@ int atom_asic_init(struct atom_context *ctx)
 
 void atom_destroy(struct atom_context *ctx)
 {
+    kvfree(ctx->scratch);
+    kfree(ctx->ws_stack);
     kfree(ctx->iio);
     kfree(ctx);
 }
@@ -67,6 +67,8 @@
 #define ATOM_CT_PS_MASK             0x7F
 #define ATOM_CT_CODE_PTR            6
 
+#define ATOM_WS_STACK_DEPTH         8
+
 #define ATOM_OP_CNT                 127
 #define ATOM_OP_EOT                 91
 
@@ -128,8 +130,18 @@ struct card_info {
     uint32_t (* pll_read)(struct card_info *, uint32_t);          /*  filled by driver */
 };
 
+/*
+ * Optional observers for the parts of a table run which never reach the
+ * card_info callbacks. Used to record a trace of a table execution.
+ */
+struct atom_hooks {
+    void (* delay)(struct atom_hooks *, uint32_t);              /*  delay in microseconds */
+    void (* fb_access)(struct atom_hooks *, uint32_t, bool);    /*  scratch index, is write */
+};
+
 struct atom_context {
     struct card_info *card;
+    struct atom_hooks *hooks;
     struct mutex     mutex;
     void const       *bios;
     uint32_t         cmd_table, data_table;
@@ -143,8 +155,12 @@ struct atom_context {
     uint8_t          shift;
     int              cs_equal, cs_above;
     int              io_mode;
-    uint32_t         *scratch;
+    uint32_t         *scratch;              /* allocated on the first FB write */
     int              scratch_size_bytes;
+    uint32_t         *ws_stack;
+    int              ws_stack_size;
+    int              ws_stack_top;
+    unsigned long    ws_heap_allocs;
     char             vbios_version[20];
 
     // uint32_t         firmware_start_offset;
@@ -156,6 +172,7 @@ extern int atom_debug;
 
 struct atom_context *atom_parse(struct card_info *, void const *);
 int atom_execute_table(struct atom_context *, int, uint32_t *);
+int __atom_execute_table(struct atom_context *, int, uint32_t *);
 int atom_asic_init(struct atom_context *);
 void atom_destroy(struct atom_context *);
 bool atom_parse_data_header(struct atom_context *ctx, int index, uint16_t *size, uint8_t *frev, uint8_t *crev, uint16_t *data_start);
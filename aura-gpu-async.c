@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#include "debug.h"
+#include "aura-gpu-async.h"
+
+/*
+ * Asynchronous transfers.
+ *
+ * Requests are pushed onto a lock-free list, bounded by a counter, and
+ * drained in submission order by an ordered worker per adapter. The worker
+ * holds the bus lock for the whole batch and brackets it with the backend's
+ * begin/end hooks, so the direct engine is opened and closed only once for
+ * any number of queued requests.
+ *
+ * Submission and teardown meet under the queue's spinlock, so once the queue
+ * is marked dying nothing more can reach its workqueue.
+ */
+
+#define AURA_I2C_QUEUE_DEPTH    64
+
+enum aura_i2c_request_state {
+    AURA_I2C_REQUEST_QUEUED,
+    AURA_I2C_REQUEST_RUNNING,
+    AURA_I2C_REQUEST_CANCELLED,
+    AURA_I2C_REQUEST_DONE,
+};
+
+struct aura_i2c_queue {
+    struct list_head                siblings;
+    struct i2c_adapter              *adapter;
+    const struct aura_i2c_queue_ops *ops;
+    struct workqueue_struct         *wq;
+    struct work_struct              work;
+    struct llist_head               submitted;
+    spinlock_t                      lock;
+    atomic_t                        pending;
+    unsigned int                    depth;
+    bool                            dying;
+};
+
+static LIST_HEAD(aura_i2c_queue_list);
+static DEFINE_MUTEX(aura_i2c_queue_lock);
+
+static void aura_i2c_queue_complete (
+    struct aura_i2c_request *request,
+    int result
+){
+    atomic_set(&request->state, AURA_I2C_REQUEST_DONE);
+    request->complete(request, result);
+}
+
+static void aura_i2c_queue_work (
+    struct work_struct *work
+){
+    struct aura_i2c_queue *queue = container_of(work, struct aura_i2c_queue, work);
+    struct i2c_adapter *adapter = queue->adapter;
+    struct aura_i2c_request *request, *next;
+    struct llist_node *list;
+    error_t err = 0;
+    bool open = false;
+    int ret;
+
+    while (NULL != (list = llist_del_all(&queue->submitted))) {
+        list = llist_reverse_order(list);
+
+        llist_for_each_entry_safe(request, next, list, node) {
+            atomic_dec(&queue->pending);
+
+            if (atomic_cmpxchg(&request->state, AURA_I2C_REQUEST_QUEUED, AURA_I2C_REQUEST_RUNNING) != AURA_I2C_REQUEST_QUEUED) {
+                aura_i2c_queue_complete(request, -ECANCELED);
+                continue;
+            }
+
+            if (!open) {
+                i2c_lock_bus(adapter, I2C_LOCK_ROOT_ADAPTER);
+                err = queue->ops->begin ? queue->ops->begin(adapter) : 0;
+                open = true;
+            }
+
+            ret = err ? err : queue->ops->xfer(adapter, request->msgs, request->num);
+            aura_i2c_queue_complete(request, ret);
+        }
+    }
+
+    if (open) {
+        if (!err && queue->ops->end)
+            queue->ops->end(adapter);
+        i2c_unlock_bus(adapter, I2C_LOCK_ROOT_ADAPTER);
+    }
+}
+
+/**
+ * aura_i2c_submit() - Queues a transfer
+ * @queue: Queue of the target adapter
+ * @request: Request with msgs, num and complete filled in
+ *
+ * The request and its messages must stay valid until the callback runs.
+ *
+ * @return: Zero, -EBUSY when the queue is full or -ESHUTDOWN when the
+ *          adapter is being removed
+ */
+error_t aura_i2c_submit (
+    struct aura_i2c_queue *queue,
+    struct aura_i2c_request *request
+){
+    unsigned long flags;
+    error_t err = 0;
+
+    if (IS_NULL(queue, request) || IS_NULL(request->complete))
+        return -EINVAL;
+
+    spin_lock_irqsave(&queue->lock, flags);
+
+    if (queue->dying) {
+        err = -ESHUTDOWN;
+        goto done;
+    }
+
+    if (atomic_inc_return(&queue->pending) > queue->depth) {
+        atomic_dec(&queue->pending);
+        err = -EBUSY;
+        goto done;
+    }
+
+    atomic_set(&request->state, AURA_I2C_REQUEST_QUEUED);
+    llist_add(&request->node, &queue->submitted);
+    queue_work(queue->wq, &queue->work);
+
+done:
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    return err;
+}
+EXPORT_SYMBOL_GPL(aura_i2c_submit);
+
+/**
+ * aura_i2c_cancel() - Cancels a queued transfer
+ * @request: A submitted request
+ *
+ * A request which has not yet started is completed with -ECANCELED once
+ * the worker reaches it. The callback runs in every case.
+ *
+ * @return: True if the request will not be transferred
+ */
+bool aura_i2c_cancel (
+    struct aura_i2c_request *request
+){
+    if (IS_NULL(request))
+        return false;
+
+    return atomic_cmpxchg(&request->state, AURA_I2C_REQUEST_QUEUED, AURA_I2C_REQUEST_CANCELLED) == AURA_I2C_REQUEST_QUEUED;
+}
+EXPORT_SYMBOL_GPL(aura_i2c_cancel);
+
+/**
+ * aura_i2c_queue_find() - Looks up the queue of an adapter
+ * @adapter: One of this module's adapters
+ *
+ * @return: The queue or NULL
+ */
+struct aura_i2c_queue *aura_i2c_queue_find (
+    struct i2c_adapter *adapter
+){
+    struct aura_i2c_queue *queue, *found = NULL;
+
+    mutex_lock(&aura_i2c_queue_lock);
+    list_for_each_entry(queue, &aura_i2c_queue_list, siblings) {
+        if (queue->adapter == adapter) {
+            found = queue;
+            break;
+        }
+    }
+    mutex_unlock(&aura_i2c_queue_lock);
+
+    return found;
+}
+EXPORT_SYMBOL_GPL(aura_i2c_queue_find);
+
+struct aura_i2c_queue *aura_i2c_queue_create (
+    struct i2c_adapter *adapter,
+    const struct aura_i2c_queue_ops *ops
+){
+    struct aura_i2c_queue *queue;
+
+    if (IS_NULL(adapter, ops) || IS_NULL(ops->xfer))
+        return ERR_PTR(-EINVAL);
+
+    queue = kzalloc(sizeof(*queue), GFP_KERNEL);
+    if (!queue)
+        return ERR_PTR(-ENOMEM);
+
+    queue->wq = alloc_ordered_workqueue("aura-i2c-%d", WQ_MEM_RECLAIM, adapter->nr);
+    if (!queue->wq) {
+        kfree(queue);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    queue->adapter = adapter;
+    queue->ops = ops;
+    queue->depth = AURA_I2C_QUEUE_DEPTH;
+    init_llist_head(&queue->submitted);
+    spin_lock_init(&queue->lock);
+    atomic_set(&queue->pending, 0);
+    INIT_WORK(&queue->work, aura_i2c_queue_work);
+
+    mutex_lock(&aura_i2c_queue_lock);
+    list_add_tail(&queue->siblings, &aura_i2c_queue_list);
+    mutex_unlock(&aura_i2c_queue_lock);
+
+    return queue;
+}
+
+void aura_i2c_queue_destroy (
+    struct aura_i2c_queue *queue
+){
+    unsigned long flags;
+
+    if (IS_NULL(queue))
+        return;
+
+    mutex_lock(&aura_i2c_queue_lock);
+    list_del(&queue->siblings);
+    mutex_unlock(&aura_i2c_queue_lock);
+
+    /* Waits out any submitter still inside aura_i2c_submit */
+    spin_lock_irqsave(&queue->lock, flags);
+    queue->dying = true;
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    /* Runs everything already queued */
+    destroy_workqueue(queue->wq);
+
+    kfree(queue);
+}
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _UAPI_AURA_GPU_ASYNC_H
+#define _UAPI_AURA_GPU_ASYNC_H
+
+#include <linux/i2c.h>
+#include <linux/llist.h>
+#include <linux/atomic.h>
+#include "include/types.h"
+
+struct aura_i2c_request;
+struct aura_i2c_queue;
+
+/**
+ * typedef aura_i2c_complete_t - Completion callback
+ * @request: The finished request
+ * @result: Number of messages transferred, or a negative error number.
+ *          -ECANCELED when the request was cancelled before it ran.
+ *
+ * Runs on the adapter's worker with the bus locked. The callback must not
+ * make synchronous transfers on the same adapter, it may free @request.
+ */
+typedef void (*aura_i2c_complete_t)(struct aura_i2c_request *request, int result);
+
+struct aura_i2c_request {
+    struct i2c_msg          *msgs;
+    int                     num;
+    aura_i2c_complete_t     complete;
+    void                    *private;
+
+    /* private */
+    struct llist_node       node;
+    atomic_t                state;
+};
+
+/**
+ * struct aura_i2c_queue_ops - Backend hooks used by the worker
+ * @begin: Optional, called once before a batch of requests
+ * @xfer: Transfers a single request, same semantics as master_xfer
+ * @end: Optional, called once after a batch of requests
+ */
+struct aura_i2c_queue_ops {
+    error_t (*begin)(struct i2c_adapter *adapter);
+    int     (*xfer)(struct i2c_adapter *adapter, struct i2c_msg *msgs, int num);
+    void    (*end)(struct i2c_adapter *adapter);
+};
+
+struct aura_i2c_queue *aura_i2c_queue_create (
+    struct i2c_adapter *adapter,
+    const struct aura_i2c_queue_ops *ops
+);
+
+void aura_i2c_queue_destroy (
+    struct aura_i2c_queue *queue
+);
+
+struct aura_i2c_queue *aura_i2c_queue_find (
+    struct i2c_adapter *adapter
+);
+
+error_t aura_i2c_submit (
+    struct aura_i2c_queue *queue,
+    struct aura_i2c_request *request
+);
+
+bool aura_i2c_cancel (
+    struct aura_i2c_request *request
+);
+
+#endif
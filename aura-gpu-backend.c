@@ -0,0 +1,519 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/async.h>
+#include <linux/bitmap.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "debug.h"
+#include "pci_ids.h"
+#include "aura-gpu-hw.h"
+#include "aura-gpu-i2c.h"
+#include "aura-gpu-ddc.h"
+#include "aura-gpu-bios.h"
+#include "aura-gpu-backend.h"
+#include "asic/asic-registers.h"
+
+/*
+ * Picks between the direct GENERIC_I2C engine and the AtomBIOS interpreter.
+ *
+ * The direct engine is much faster but is not known to work on every asic,
+ * so in auto mode it is only kept when a self-test passes: the controller
+ * at selftest_addr must answer byte reads of its register 0. The read only
+ * moves the controller's register pointer, no LED state is written. The
+ * same reads, repeated, give the figures which are reported. Asking for
+ * the direct backend keeps it even when the self-test fails.
+ *
+ * Every matching GPU gets its own backend, with one adapter per usable line.
+ * All adapters of a GPU share its engine lock, the lines being multiplexed
+ * onto the single GENERIC_I2C engine. Optionally, the hardware assisted
+ * lines are moved to the display core's DC_I2C engine instead, which has
+ * its own lock, so transfers on the two engines overlap. The direct
+ * backend then covers both engines. The probes of different GPUs run in
+ * parallel. Each maps its GPU's ROM and registers once, and the adapters
+ * of all lines share them, along with the bios interpreter of the bios
+ * backend. The registry keeps the results until the module is unloaded.
+ */
+
+#define BACKEND_BENCH_XFERS     16
+/* The line mux is a 4 bit field */
+#define BACKEND_LINE_COUNT      16
+/* Used when the bios has no GPIO_I2C_Info table */
+#define BACKEND_DEFAULT_LINE    6
+#define BACKEND_DEFAULT_SCL_PIN 0x29
+#define BACKEND_DEFAULT_SDA_PIN 0x28
+
+static char *backend_name = "auto";
+module_param_named(backend, backend_name, charp, 0444);
+MODULE_PARM_DESC(backend, "I2C backend to use: auto, direct or bios, direct is kept even if its self-test fails (default: auto)");
+
+static bool use_ddc = false;
+module_param_named(ddc, use_ddc, bool, 0444);
+MODULE_PARM_DESC(ddc, "Drive hardware assisted lines with the DC_I2C engine, in parallel with the GENERIC_I2C engine (default: false)");
+
+static ushort selftest_addr = 0x29;
+module_param(selftest_addr, ushort, 0444);
+MODULE_PARM_DESC(selftest_addr, "Address whose register 0 must read back for the direct engine self-test (default: 0x29)");
+
+static LIST_HEAD(backend_list);
+static DEFINE_MUTEX(backend_lock);
+static ASYNC_DOMAIN_EXCLUSIVE(backend_domain);
+
+static const char * const backend_names[] = {
+    [AURA_BACKEND_DIRECT] = "direct",
+    [AURA_BACKEND_BIOS]   = "bios",
+};
+
+struct backend_bench {
+    unsigned int    xfers;
+    u64             elapsed_us;
+};
+
+/*
+ * Reads register 0 of the self-test device. A register read always goes out
+ * on the bus, whereas the bios adapter answers repeated probes from its
+ * presence cache.
+ */
+static error_t backend_benchmark (
+    struct i2c_adapter *adapter,
+    struct backend_bench *bench
+){
+    union i2c_smbus_data data;
+    ktime_t start = ktime_get();
+    int ret;
+
+    for (bench->xfers = 0; bench->xfers < BACKEND_BENCH_XFERS; bench->xfers++) {
+        ret = i2c_smbus_xfer(adapter, selftest_addr, 0, I2C_SMBUS_READ, 0, I2C_SMBUS_BYTE_DATA, &data);
+        if (ret < 0)
+            return ret;
+    }
+
+    bench->elapsed_us = max_t(s64, ktime_us_delta(ktime_get(), start), 1);
+
+    return 0;
+}
+
+static void backend_report (
+    struct aura_backend *backend,
+    const struct backend_bench *bench
+){
+    if (!bench->xfers) {
+        AURA_INFO("%s: using the %s backend on %d lines",
+            pci_name(backend->pci_dev),
+            backend_names[backend->type],
+            backend->count
+        );
+        return;
+    }
+
+    AURA_INFO("%s: using the %s backend on %d lines, %u transfers in %llu us, %llu per second",
+        pci_name(backend->pci_dev),
+        backend_names[backend->type],
+        backend->count,
+        bench->xfers,
+        bench->elapsed_us,
+        div64_u64((u64)bench->xfers * USEC_PER_SEC, bench->elapsed_us)
+    );
+}
+
+/*
+ * Finds the DDC channel of a line the way the display core does, from the
+ * register holding its clock pad. Lines whose pads are not a DDC channel's,
+ * or which the asic gives no offsets for, stay on the GENERIC_I2C engine.
+ *
+ * @return: The channel, or -ENOENT
+ */
+static int backend_ddc_channel (
+    const struct asic_context *asic,
+    const struct i2c_info *info
+){
+    uint16_t clk_a = info->gpio_info.clk_a_register_index;
+    int i;
+
+    if (!asic || !clk_a)
+        return -ENOENT;
+
+    /* Both pads of a DDC channel live in its DC_GPIO_DDCx_A */
+    if (info->gpio_info.data_a_register_index != clk_a)
+        return -ENOENT;
+
+    for (i = 0; i < DC_I2C_DDC_COUNT; i++) {
+        if (asic->i2c_registers->DC_GPIO_DDC_A[i] == clk_a)
+            return i;
+    }
+
+    return -ENOENT;
+}
+
+/*
+ * Every line of the GPIO_I2C_Info table gets an adapter, apart from those
+ * wired to a display connector, which amdgpu already drives. Bioses without
+ * the table get the line and pins the driver always used.
+ */
+static void backend_find_lines (
+    struct aura_backend *backend
+){
+    DECLARE_BITMAP(skip, BACKEND_LINE_COUNT);
+    const struct pci_device_id *match;
+    const struct asic_context *asic = NULL;
+    struct graphics_object_id object_id;
+    struct atom_bios *bios = backend->resources.bios;
+    struct aura_gpu_line *line;
+    struct i2c_info info;
+    uint8_t i, count;
+    int channel;
+
+    bitmap_zero(skip, BACKEND_LINE_COUNT);
+
+    match = pci_match_id(pciidlist, backend->pci_dev);
+    if (match)
+        asic = aura_gpu_i2c_get_ddc_context(match->driver_data);
+
+    if (!bios)
+        goto fallback;
+
+    count = atom_bios_get_connectors_number(bios);
+    for (i = 0; i < count; i++) {
+        if (!atom_bios_get_connector_id(bios, i, &object_id))
+            continue;
+
+        if (!atom_bios_get_i2c_info(bios, &object_id, &info) && info.line < BACKEND_LINE_COUNT)
+            set_bit(info.line, skip);
+    }
+
+    count = atom_bios_get_gpio_count(bios);
+    for (i = 0; i < count && backend->count < AURA_GPU_MAX_LINES; i++) {
+        if (atom_bios_get_gpio_info(bios, i, &info) || info.line >= BACKEND_LINE_COUNT)
+            continue;
+
+        /* Also skips duplicate entries */
+        if (test_and_set_bit(info.line, skip))
+            continue;
+
+        channel = use_ddc && info.hw_assist ? backend_ddc_channel(asic, &info) : -ENOENT;
+
+        line = &backend->lines[backend->count++];
+        line->number  = info.line;
+        line->ddc     = channel >= 0;
+        line->channel = line->ddc ? channel : 0;
+        line->has_pins =
+            !atom_bios_get_gpio_pin_id(bios, info.gpio_info.clk_a_register_index, info.gpio_info.clk_a_shift, &line->scl_pin) &&
+            !atom_bios_get_gpio_pin_id(bios, info.gpio_info.data_a_register_index, info.gpio_info.data_a_shift, &line->sda_pin);
+
+        AURA_DBG("%s: line %u, pins %s %x/%x", pci_name(backend->pci_dev),
+            line->number, line->has_pins ? "found" : "missing", line->scl_pin, line->sda_pin);
+
+        if (line->ddc)
+            AURA_DBG("%s: line %u on the DC_I2C engine, channel %u", pci_name(backend->pci_dev),
+                line->number, line->channel);
+    }
+
+    if (backend->count)
+        return;
+
+fallback:
+    backend->lines[0] = (struct aura_gpu_line){
+        .number     = BACKEND_DEFAULT_LINE,
+        .has_pins   = true,
+        .scl_pin    = BACKEND_DEFAULT_SCL_PIN,
+        .sda_pin    = BACKEND_DEFAULT_SDA_PIN,
+    };
+    backend->count = 1;
+}
+
+static void backend_destroy_adapters (
+    struct aura_backend *backend,
+    enum aura_backend_type type,
+    int count
+){
+    while (count-- > 0) {
+        if (type == AURA_BACKEND_DIRECT && backend->lines[count].ddc)
+            aura_ddc_adapter_destroy(backend->adapters[count]);
+        else if (type == AURA_BACKEND_DIRECT)
+            gpu_adapter_destroy(backend->adapters[count]);
+        else
+            aura_i2c_bios_destroy(backend->adapters[count]);
+
+        backend->adapters[count] = NULL;
+    }
+}
+
+static error_t backend_create_adapters (
+    struct aura_backend *backend,
+    enum aura_backend_type type
+){
+    struct i2c_adapter *adapter;
+    int i;
+
+    for (i = 0; i < backend->count; i++) {
+        if (type == AURA_BACKEND_DIRECT && backend->lines[i].ddc)
+            adapter = aura_ddc_adapter_create(backend->pci_dev, &backend->ddc, &backend->lines[i]);
+        else if (type == AURA_BACKEND_DIRECT)
+            adapter = gpu_adapter_create(backend->pci_dev, &backend->engine, &backend->lines[i]);
+        else
+            adapter = aura_i2c_bios_create(backend->pci_dev, &backend->engine, &backend->lines[i]);
+
+        if (IS_ERR(adapter)) {
+            backend_destroy_adapters(backend, type, i);
+            return PTR_ERR(adapter);
+        }
+
+        backend->adapters[i] = adapter;
+    }
+
+    backend->type = type;
+
+    return 0;
+}
+
+/*
+ * Passes when the self-test address answers on any of the lines. A @forced
+ * backend keeps its adapters whatever the self-test says.
+ */
+static error_t backend_create_direct (
+    struct aura_backend *backend,
+    struct backend_bench *bench,
+    bool forced
+){
+    error_t err = -ENODEV;
+    int i;
+
+    for (i = 0; i < backend->count; i++) {
+        if (!backend->lines[i].has_pins && !backend->lines[i].ddc) {
+            AURA_WARN("%s: no pins for line %u, the direct engine cannot drive it",
+                pci_name(backend->pci_dev), backend->lines[i].number);
+            return -ENODEV;
+        }
+    }
+
+    err = backend_create_adapters(backend, AURA_BACKEND_DIRECT);
+    if (err)
+        return err;
+
+    for (i = 0; i < backend->count; i++) {
+        err = backend_benchmark(backend->adapters[i], bench);
+        if (!err)
+            return 0;
+    }
+
+    AURA_WARN("%s: direct engine self-test at 0x%02x failed: %d", pci_name(backend->pci_dev), selftest_addr, err);
+
+    if (forced) {
+        AURA_WARN("%s: keeping the direct backend as requested", pci_name(backend->pci_dev));
+        bench->xfers = 0;
+        return 0;
+    }
+
+    backend_destroy_adapters(backend, AURA_BACKEND_DIRECT, backend->count);
+
+    return err;
+}
+
+static error_t backend_create_bios (
+    struct aura_backend *backend,
+    struct backend_bench *bench
+){
+    struct aura_gpu_interpreter *interpreter;
+    error_t err;
+    int i;
+
+    interpreter = aura_i2c_bios_interpreter_create(&backend->resources);
+    if (IS_ERR(interpreter))
+        return PTR_ERR(interpreter);
+
+    backend->resources.interpreter = interpreter;
+
+    err = backend_create_adapters(backend, AURA_BACKEND_BIOS);
+    if (err) {
+        backend->resources.interpreter = NULL;
+        aura_i2c_bios_interpreter_destroy(interpreter);
+        return err;
+    }
+
+    /* Only for the report, the interpreter is the last resort anyway */
+    bench->xfers = 0;
+    for (i = 0; i < backend->count; i++) {
+        if (!backend_benchmark(backend->adapters[i], bench))
+            break;
+
+        bench->xfers = 0;
+    }
+
+    return 0;
+}
+
+static void backend_destroy_resources (
+    struct aura_gpu_resources *resources
+){
+    if (resources->interpreter)
+        aura_i2c_bios_interpreter_destroy(resources->interpreter);
+
+    if (resources->bios)
+        atom_bios_release(resources->bios);
+
+    if (resources->reg_service)
+        aura_gpu_reg_destroy(resources->reg_service);
+}
+
+/*
+ * Maps the registers and the ROM once for every adapter of the GPU. A bios
+ * which cannot be read only costs the line table and the reference clock,
+ * the direct engine still works without them.
+ */
+static error_t backend_create_resources (
+    struct aura_backend *backend
+){
+    struct aura_gpu_resources *resources = &backend->resources;
+    struct aura_reg_service *reg_service;
+    struct atom_bios *bios;
+
+    reg_service = aura_gpu_reg_create(backend->pci_dev);
+    if (IS_ERR(reg_service))
+        return PTR_ERR(reg_service);
+
+    resources->reg_service = reg_service;
+
+    bios = atom_bios_create(backend->pci_dev);
+    if (IS_ERR_OR_NULL(bios)) {
+        AURA_DBG("%s: bios unavailable: %ld", pci_name(backend->pci_dev), PTR_ERR(bios));
+        return 0;
+    }
+
+    resources->bios = bios;
+    resources->reference_frequency = aura_gpu_i2c_get_reference(bios);
+
+    return 0;
+}
+
+/* Takes over the caller's reference to @pci_dev on success */
+static struct aura_backend *aura_backend_create (
+    struct pci_dev *pci_dev
+){
+    struct aura_backend *backend;
+    struct backend_bench bench = { 0 };
+    bool direct, bios;
+    error_t err;
+
+    direct = sysfs_streq(backend_name, "direct") || sysfs_streq(backend_name, "auto");
+    bios   = sysfs_streq(backend_name, "bios")   || sysfs_streq(backend_name, "auto");
+
+    if (!direct && !bios) {
+        AURA_ERR("Unknown backend '%s'", backend_name);
+        return ERR_PTR(-EINVAL);
+    }
+
+    backend = kzalloc(sizeof(*backend), GFP_KERNEL);
+    if (!backend)
+        return ERR_PTR(-ENOMEM);
+
+    backend->pci_dev = pci_dev;
+    mutex_init(&backend->arbiter.lock);
+    mutex_init(&backend->engine.lock);
+    mutex_init(&backend->ddc.lock);
+    backend->engine.arbiter = &backend->arbiter;
+    backend->ddc.arbiter    = &backend->arbiter;
+    backend->engine.resources = &backend->resources;
+    backend->ddc.resources    = &backend->resources;
+
+    err = backend_create_resources(backend);
+    if (err)
+        goto error_free_resources;
+
+    backend_find_lines(backend);
+
+    err = direct ? backend_create_direct(backend, &bench, !bios) : -ENODEV;
+
+    if (err && bios)
+        err = backend_create_bios(backend, &bench);
+
+    if (err)
+        goto error_free_resources;
+
+    backend_report(backend, &bench);
+
+    return backend;
+
+error_free_resources:
+    backend_destroy_resources(&backend->resources);
+    kfree(backend);
+
+    return ERR_PTR(err);
+}
+
+static void aura_backend_destroy (
+    struct aura_backend *backend
+){
+    backend_destroy_adapters(backend, backend->type, backend->count);
+    backend_destroy_resources(&backend->resources);
+
+    pci_dev_put(backend->pci_dev);
+    kfree(backend);
+}
+
+static void aura_backend_probe (
+    void *data,
+    async_cookie_t cookie
+){
+    struct pci_dev *pci_dev = data;
+    struct aura_backend *backend;
+
+    backend = aura_backend_create(pci_dev);
+    if (IS_ERR(backend)) {
+        AURA_WARN("%s: no adapter created: %ld", pci_name(pci_dev), PTR_ERR(backend));
+        pci_dev_put(pci_dev);
+        return;
+    }
+
+    mutex_lock(&backend_lock);
+    list_add_tail(&backend->list, &backend_list);
+    mutex_unlock(&backend_lock);
+}
+
+/**
+ * aura_backends_create() - Creates an adapter on every supported GPU
+ *
+ * @return: Zero when at least one adapter was created
+ */
+error_t aura_backends_create (
+    void
+){
+    struct pci_dev *pci_dev = NULL;
+    error_t err;
+
+    while (NULL != (pci_dev = pci_get_device(PCI_ANY_ID, PCI_ANY_ID, pci_dev))) {
+        if (!pci_match_id(pciidlist, pci_dev))
+            continue;
+
+        AURA_DBG("Detected AURA capable GPU %x:%x", pci_dev->subsystem_vendor, pci_dev->subsystem_device);
+
+        /* The iterator drops its own reference on the next call */
+        async_schedule_domain(aura_backend_probe, pci_dev_get(pci_dev), &backend_domain);
+    }
+
+    async_synchronize_full_domain(&backend_domain);
+
+    mutex_lock(&backend_lock);
+    err = list_empty(&backend_list) ? -ENODEV : 0;
+    mutex_unlock(&backend_lock);
+
+    return err;
+}
+
+void aura_backends_destroy (
+    void
+){
+    struct aura_backend *backend, *next;
+
+    mutex_lock(&backend_lock);
+
+    list_for_each_entry_safe(backend, next, &backend_list, list) {
+        list_del(&backend->list);
+        aura_backend_destroy(backend);
+    }
+
+    mutex_unlock(&backend_lock);
+}
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _UAPI_AURA_GPU_BACKEND_H
+#define _UAPI_AURA_GPU_BACKEND_H
+
+#include <linux/i2c.h>
+#include <linux/list.h>
+#include <linux/mutex.h>
+#include <linux/pci.h>
+#include "include/types.h"
+
+#define AURA_GPU_MAX_LINES      8
+
+enum aura_backend_type {
+    AURA_BACKEND_DIRECT,
+    AURA_BACKEND_BIOS,
+};
+
+/**
+ * struct aura_gpu_arbiter - Software's claim on the DC_I2C arbiter
+ * @lock: Serializes requests and releases of the grant
+ * @users: Engines currently using the grant, the first one requested it
+ */
+struct aura_gpu_arbiter {
+    struct mutex    lock;
+    unsigned int    users;
+};
+
+struct atom_bios;
+struct aura_reg_service;
+struct aura_gpu_interpreter;
+
+/**
+ * struct aura_gpu_resources - What every adapter of a GPU shares
+ * @bios: The GPU's bios, NULL when it could not be read
+ * @reg_service: Register access, register shadows included
+ * @reference_frequency: Engine reference clock in kHz, zero when unknown
+ * @interpreter: Runs the bios tables, only set for the bios backend
+ */
+struct aura_gpu_resources {
+    struct atom_bios            *bios;
+    struct aura_reg_service     *reg_service;
+    uint32_t                    reference_frequency;
+    struct aura_gpu_interpreter *interpreter;
+};
+
+/**
+ * struct aura_gpu_engine - One i2c engine of a GPU
+ * @lock: Held across every use of the engine, whichever line it drives
+ * @owner: Adapter which last configured the engine, NULL once released
+ * @arbiter: Shared by both engines of the GPU
+ * @resources: Shared by both engines of the GPU
+ */
+struct aura_gpu_engine {
+    struct mutex                lock;
+    void                        *owner;
+    struct aura_gpu_arbiter     *arbiter;
+    struct aura_gpu_resources   *resources;
+};
+
+/**
+ * struct aura_gpu_line - An i2c line found in the GPIO_I2C_Info table
+ * @number: Line mux, as passed to ProcessI2cChannelTransaction
+ * @has_pins: The pads below were found in the GPIO_Pin_LUT
+ * @scl_pin: GENERIC_I2C_SCL_PIN_SEL for the line
+ * @sda_pin: GENERIC_I2C_SDA_PIN_SEL for the line
+ * @ddc: Driven by the DC_I2C engine
+ * @channel: DC_I2C_DDC_SELECT for the line, valid when @ddc is set
+ */
+struct aura_gpu_line {
+    uint8_t     number;
+    bool        has_pins;
+    uint8_t     scl_pin;
+    uint8_t     sda_pin;
+    bool        ddc;
+    uint8_t     channel;
+};
+
+/**
+ * struct aura_backend - The adapters chosen for a GPU
+ * @type: Which implementation drives @adapters
+ * @pci_dev: The GPU, a reference is held for the backend's lifetime
+ * @resources: Shared by @engine and @ddc
+ * @arbiter: Shared by @engine and @ddc
+ * @engine: The GENERIC_I2C engine, shared by all @adapters of plain lines
+ * @ddc: The DC_I2C engine, shared by all @adapters of @ddc lines
+ * @count: Number of @lines and @adapters
+ * @lines: Lines with an adapter
+ * @adapters: Registered adapters, one per line
+ * @list: Entry in the registry
+ */
+struct aura_backend {
+    enum aura_backend_type      type;
+    struct pci_dev              *pci_dev;
+    struct aura_gpu_resources   resources;
+    struct aura_gpu_arbiter     arbiter;
+    struct aura_gpu_engine      engine;
+    struct aura_gpu_engine      ddc;
+    int                         count;
+    struct aura_gpu_line        lines[AURA_GPU_MAX_LINES];
+    struct i2c_adapter          *adapters[AURA_GPU_MAX_LINES];
+    struct list_head            list;
+};
+
+error_t aura_backends_create (
+    void
+);
+
+void aura_backends_destroy (
+    void
+);
+
+#endif
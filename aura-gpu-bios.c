@@ -312,6 +312,17 @@ struct atom_gpio_pin_assignment {
     uint8_t  reserved;
 };
 
+struct atom_gpio_pin_assignment_v1_1 {
+    uint16_t usGpioPin_AIndex;
+    uint8_t  ucGpio_Pin_BitShift;
+    uint8_t  ucGPIO_ID;
+};
+
+struct atom_gpio_pin_lut_v1_1 {
+    struct  atom_common_table_header      table_header;
+    struct  atom_gpio_pin_assignment_v1_1 asGPIO_Pin[1];
+};
+
 struct atom_gpio_pin_lut_v2_1 {
     struct  atom_common_table_header  table_header;
     /*the real number of this included in the structure is calcualted by using the (whole structure size - the header size)/size of atom_gpio_pin_lut  */
@@ -546,6 +557,24 @@ struct atom_firmware_info_v2_2 {
     uint32_t  ulReserved10[3];            // New added comparing to previous version
 };
 
+struct atom_firmware_vram_reserve_info {
+    uint32_t  ulStartAddrUsedByFirmware;
+    uint16_t  usFirmwareUseInKb;
+    uint16_t  usReserved;
+};
+
+struct atom_vram_usagebyfirmware_v1_1 {
+    struct  atom_common_table_header  table_header;
+    struct  atom_firmware_vram_reserve_info asFirmwareVramReserveInfo[1];
+};
+
+struct atom_vram_usagebyfirmware_v2_1 {
+    struct  atom_common_table_header  table_header;
+    uint32_t  start_address_in_kb;
+    uint16_t  used_by_firmware_in_kb;
+    uint16_t  used_by_driver_in_kb;
+};
+
 #pragma pack()
 
 enum revision {
@@ -1675,6 +1704,52 @@ void atom_bios_release(
     kfree(context);
 }
 
+/* The GPIO_I2C_Info table only exists in v1.x master data tables */
+static struct atom_gpio_i2c_info *get_gpio_i2c_table (
+    struct atom_context *context,
+    uint32_t *count
+){
+    struct atom_gpio_i2c_info *header;
+    uint32_t size;
+
+    switch (table_revision(context->master_data_table)) {
+        case VERSION_1_1:
+        case VERSION_1_2:
+        case VERSION_1_3:
+        case VERSION_1_4:
+            break;
+        default:
+            return NULL;
+    }
+
+    header = GET_IMAGE(context, struct atom_gpio_i2c_info, table_list_field(context, v1_1, gpio_i2c_info));
+    if (!header || 1 != header->table_header.content_revision)
+        return NULL;
+
+    size = le16_to_cpu(header->table_header.structuresize);
+    if (size < sizeof(struct atom_common_table_header) + sizeof(struct atom_gpio_i2c_assigment))
+        return NULL;
+
+    *count = min_t(uint32_t, ATOM_MAX_SUPPORTED_DEVICE,
+        (size - sizeof(struct atom_common_table_header)) / sizeof(struct atom_gpio_i2c_assigment));
+
+    return header;
+}
+
+uint8_t atom_bios_get_gpio_count(
+    struct atom_bios *bios
+){
+    uint32_t count;
+
+    if (WARN_ON(bios == NULL))
+        return 0;
+
+    if (!get_gpio_i2c_table(to_atom_context(bios), &count))
+        return 0;
+
+    return count;
+}
+
 error_t atom_bios_get_gpio_info(
     struct atom_bios *bios,
     uint8_t index,
@@ -1684,33 +1759,16 @@ error_t atom_bios_get_gpio_info(
     struct atom_gpio_i2c_info *header;
     struct atom_gpio_i2c_assigment *pin;
     uint32_t table_count;
-    uint32_t i2c_table_offset;
 
     if (WARN_ON(info == NULL))
         return BP_RESULT_BADINPUT;
 
-    i2c_table_offset = table_list_field(context, v1_1, gpio_i2c_info);
-    header = GET_IMAGE(context, struct atom_gpio_i2c_info, i2c_table_offset);
+    header = get_gpio_i2c_table(context, &table_count);
     if (!header)
-        return BP_RESULT_BADBIOSTABLE;
-
-    if (sizeof(struct atom_common_table_header) +
-        sizeof(struct atom_gpio_i2c_assigment) >
-        le16_to_cpu(header->table_header.structuresize)
-    ){
-        return BP_RESULT_BADBIOSTABLE;
-    }
-
-    if (1 != header->table_header.content_revision)
         return BP_RESULT_UNSUPPORTED;
 
-    /* get data count */
-    table_count = (le16_to_cpu(header->table_header.structuresize) -
-                   sizeof(struct atom_common_table_header)) /
-                   sizeof(struct atom_gpio_i2c_assigment);
-
-    if (table_count < index)
-        return BP_RESULT_BADBIOSTABLE;
+    if (index >= table_count)
+        return BP_RESULT_NORECORD;
 
     pin = &header->asGPIO_Info[index];
 
@@ -1773,6 +1831,80 @@ error_t atom_bios_get_gpio_info(
     return BP_RESULT_OK;
 }
 
+/**
+ * atom_bios_get_gpio_pin_id() - Looks up a pad in the GPIO_Pin_LUT
+ * @bios: Parsed bios
+ * @reg_index: The pad's A register, as found in the GPIO_I2C_Info table
+ * @shift: The pad's bit within @reg_index
+ * @pin_id: Receives the GPIO id, as used by the pin selection registers
+ *
+ * @return: Zero or BP_RESULT_NORECORD when the pad is not listed
+ */
+error_t atom_bios_get_gpio_pin_id(
+    struct atom_bios *bios,
+    uint32_t reg_index,
+    uint8_t shift,
+    uint8_t *pin_id
+){
+    struct atom_context *context = to_atom_context(bios);
+    struct atom_gpio_pin_lut_v1_1 *lut_v1_1;
+    struct atom_gpio_pin_lut_v2_1 *lut_v2_1;
+    uint32_t offset, size, count, i;
+
+    if (WARN_ON(bios == NULL || pin_id == NULL))
+        return BP_RESULT_BADINPUT;
+
+    switch (table_revision(context->master_data_table)) {
+        case VERSION_1_1:
+        case VERSION_1_2:
+        case VERSION_1_3:
+        case VERSION_1_4:
+            offset = table_list_field(context, v1_1, gpio_pin_lut);
+            lut_v1_1 = GET_IMAGE(context, struct atom_gpio_pin_lut_v1_1, offset);
+            if (!lut_v1_1)
+                return BP_RESULT_BADBIOSTABLE;
+
+            size = le16_to_cpu(lut_v1_1->table_header.structuresize);
+            if (offset + size >= context->size || size < sizeof(struct atom_common_table_header))
+                return BP_RESULT_BADBIOSTABLE;
+
+            count = (size - sizeof(struct atom_common_table_header)) / sizeof(struct atom_gpio_pin_assignment_v1_1);
+            for (i = 0; i < count; i++) {
+                if (le16_to_cpu(lut_v1_1->asGPIO_Pin[i].usGpioPin_AIndex) == reg_index &&
+                    lut_v1_1->asGPIO_Pin[i].ucGpio_Pin_BitShift == shift
+                ){
+                    *pin_id = lut_v1_1->asGPIO_Pin[i].ucGPIO_ID;
+                    return BP_RESULT_OK;
+                }
+            }
+            return BP_RESULT_NORECORD;
+        case VERSION_2_1:
+        case VERSION_2_2:
+            offset = table_list_field(context, v2_1, gpio_pin_lut);
+            lut_v2_1 = GET_IMAGE(context, struct atom_gpio_pin_lut_v2_1, offset);
+            if (!lut_v2_1)
+                return BP_RESULT_BADBIOSTABLE;
+
+            size = le16_to_cpu(lut_v2_1->table_header.structuresize);
+            if (offset + size >= context->size || size < sizeof(struct atom_common_table_header))
+                return BP_RESULT_BADBIOSTABLE;
+
+            count = (size - sizeof(struct atom_common_table_header)) / sizeof(struct atom_gpio_pin_assignment);
+            for (i = 0; i < count; i++) {
+                if (le32_to_cpu(lut_v2_1->gpio_pin[i].data_a_reg_index) == reg_index &&
+                    lut_v2_1->gpio_pin[i].gpio_bitshift == shift
+                ){
+                    *pin_id = lut_v2_1->gpio_pin[i].gpio_id;
+                    return BP_RESULT_OK;
+                }
+            }
+            return BP_RESULT_NORECORD;
+        default:
+            AURA_ERR("Unexpected master_data_table version");
+            return BP_RESULT_BADBIOSTABLE;
+    }
+}
+
 
 
 
@@ -1898,3 +2030,49 @@ error_t atom_bios_get_crystal_frequency (
             return BP_RESULT_BADBIOSTABLE;
     }
 }
+
+/**
+ * atom_bios_get_scratch_size() - Reads the size of the driver's FB scratch area
+ * @bios: Bios to query
+ * @size: Receives the size in bytes, may be zero
+ *
+ * Same source amdgpu uses to size its atom scratch buffer.
+ */
+error_t atom_bios_get_scratch_size (
+    struct atom_bios* bios,
+    uint32_t *size
+){
+    struct atom_context *context = to_atom_context(bios);
+    struct atom_vram_usagebyfirmware_v1_1 *usage_v1_1;
+    struct atom_vram_usagebyfirmware_v2_1 *usage_v2_1;
+    uint32_t offset;
+
+    if (WARN_ON(bios == NULL || size == NULL))
+        return -EINVAL;
+
+    switch (table_revision(context->master_data_table)) {
+        case VERSION_1_1:
+        case VERSION_1_2:
+        case VERSION_1_3:
+        case VERSION_1_4:
+            offset = table_list_field(context, v1_1, vram_usagebyfirmware);
+            usage_v1_1 = GET_IMAGE(context, struct atom_vram_usagebyfirmware_v1_1, offset);
+            if (!offset || !usage_v1_1)
+                return BP_RESULT_BADBIOSTABLE;
+
+            *size = le16_to_cpu(usage_v1_1->asFirmwareVramReserveInfo[0].usFirmwareUseInKb) * 1024;
+            return 0;
+        case VERSION_2_1:
+        case VERSION_2_2:
+            offset = table_list_field(context, v2_1, vram_usagebyfirmware);
+            usage_v2_1 = GET_IMAGE(context, struct atom_vram_usagebyfirmware_v2_1, offset);
+            if (!offset || !usage_v2_1)
+                return BP_RESULT_BADBIOSTABLE;
+
+            *size = le16_to_cpu(usage_v2_1->used_by_driver_in_kb) * 1024;
+            return 0;
+        default:
+            AURA_ERR("Unexpected master_data_table version");
+            return BP_RESULT_BADBIOSTABLE;
+    }
+}
@@ -70,9 +70,15 @@ struct graphics_object_id {
     uint32_t  reserved:16; /* for padding. total size should be u32 */
 };
 
+uint8_t
+atom_bios_get_gpio_count (struct atom_bios *bios);
+
 error_t
 atom_bios_get_gpio_info (struct atom_bios *bios, uint8_t index, struct i2c_info *info);
 
+error_t
+atom_bios_get_gpio_pin_id (struct atom_bios *bios, uint32_t reg_index, uint8_t shift, uint8_t *pin_id);
+
 uint8_t
 atom_bios_get_connectors_number (struct atom_bios *bios);
 
@@ -85,6 +91,9 @@ atom_bios_get_i2c_info (struct atom_bios *bios, struct graphics_object_id *objec
 error_t
 atom_bios_get_crystal_frequency (struct atom_bios* bios, uint32_t *frequency);
 
+error_t
+atom_bios_get_scratch_size (struct atom_bios* bios, uint32_t *size);
+
 struct atom_bios*
 atom_bios_create (struct pci_dev *pci_dev);
 
@@ -0,0 +1,859 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/i2c.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+
+#include "debug.h"
+#include "pci_ids.h"
+#include "aura-gpu-reg.h"
+#include "aura-gpu-ddc.h"
+#include "aura-gpu-i2c.h"
+#include "aura-gpu-trace.h"
+#include "aura-gpu-async.h"
+#include "aura-gpu-stats.h"
+#include "aura-gpu-backend.h"
+#include "asic/asic-registers.h"
+
+/*
+ * Drives the display core's DC_I2C engine, the one amdgpu uses for DDC.
+ *
+ * The engine is separate from GENERIC_I2C, with its own buffer and
+ * transaction registers, so a transfer on a DDC line runs alongside one on
+ * the GENERIC_I2C engine. The DDC channels themselves share that buffer
+ * through DC_I2C_DDC_SELECT, which serializes them behind one engine lock.
+ *
+ * Up to four transactions run from a single GO, so the usual write of an
+ * index followed by a read completes without a round trip through here.
+ */
+
+enum {
+    DDC_I2C_DEFAULT_SPEED    = 50,
+    /* Smallest buffer of the supported asics, addresses included */
+    DDC_I2C_BUFFER_SIZE      = 16,
+    /* DC_I2C_DDC1_TIME_LIMIT, as programmed by the display core */
+    DDC_I2C_TIME_LIMIT       = 255,
+    /* START, repeated START and STOP conditions, in bit times */
+    DDC_I2C_FRAMING_BITS     = 3,
+    /* Status checks once the modelled bus time has passed, in us */
+    DDC_I2C_POLL_INTERVAL    = 20,
+    DDC_I2C_TIMEOUT          = 10000,
+    /* Bounded wait for the display core to hand over the block, in us */
+    DDC_I2C_ARBITRATION_WAIT = 10000,
+    DDC_I2C_ARBITRATION_POLL = 50,
+};
+
+struct aura_ddc_context {
+    struct aura_reg_service     *reg_service;
+    const struct asic_context   *asic;
+
+    const struct i2c_registers  *registers;
+    const struct i2c_shift      *shifts;
+    const struct i2c_mask       *masks;
+
+    struct i2c_adapter          i2c_adapter;
+    struct aura_i2c_queue       *queue;
+    struct aura_stats           *stats;
+
+    /* Shared with the adapters of the GPU's other DDC lines */
+    struct aura_gpu_engine      *engine;
+    uint8_t                     channel;
+
+    /* Raw DC_I2C_DDCx_SPEED found on open, restored on close */
+    uint32_t                    original_speed;
+    /* In kHz */
+    uint32_t                    speed;
+    /* Engine reference clock in kHz, zero leaves the speed untouched */
+    uint32_t                    reference_frequency;
+
+    bool                        faulted;
+};
+
+#define context_from_adapter(ptr) ( \
+    container_of(ptr, struct aura_ddc_context, i2c_adapter) \
+)
+
+#define ASIC_FIELDS(_asic, _field, _value)                      \
+{                                                               \
+    .mask  = _asic->i2c_masks->_field,                          \
+    .shift = _asic->i2c_shifts->_field,                         \
+    .value = _value                                             \
+}
+
+
+/*
+ * Whether the display core, or the DMCU, currently holds the DC_I2C block.
+ * Only asked while no engine of ours holds the grant, so any status other
+ * than idle is a transfer someone else started, or left behind.
+ */
+static bool arbiter_contended (
+    struct aura_reg_service *reg,
+    const struct asic_context *asic
+){
+    struct reg_fields arbitration = ASIC_FIELDS(asic, DC_I2C_REG_RW_CNTL_STATUS, 0);
+    struct reg_fields status = ASIC_FIELDS(asic, DC_I2C_SW_STATUS, 0);
+
+    reg_get_ex(reg, asic->i2c_registers->DC_I2C_ARBITRATION, &arbitration, 1);
+    if (arbitration.value == DC_I2C_REG_RW_CNTL_STATUS_DMCU_ONLY)
+        return true;
+
+    reg_get_ex(reg, asic->i2c_registers->DC_I2C_SW_STATUS, &status, 1);
+
+    return status.value != DC_I2C_STATUS__DC_I2C_STATUS_IDLE;
+}
+
+/* Whether the display core's hardware requests, such as EDID polls, hold the channel */
+static bool channel_busy (
+    struct aura_reg_service *reg,
+    const struct asic_context *asic,
+    uint8_t channel
+){
+    struct reg_fields status = ASIC_FIELDS(asic, DC_I2C_DDC1_HW_STATUS, 0);
+
+    reg_get_ex(reg, asic->i2c_registers->DC_I2C_DDC_HW_STATUS[channel], &status, 1);
+
+    return status.value == DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_HW;
+}
+
+/* The DC_I2C block as a whole when @channel is negative, otherwise just the channel */
+static bool display_core_busy (
+    struct aura_reg_service *reg,
+    const struct asic_context *asic,
+    int channel
+){
+    if (channel < 0)
+        return arbiter_contended(reg, asic);
+
+    return channel_busy(reg, asic, channel);
+}
+
+/*
+ * Bounded wait for the display core to finish with the DC_I2C block, or
+ * with a single DDC channel when @channel is not negative.
+ *
+ * @return: Zero when free at once, one when it had to wait, or -EBUSY
+ */
+static int display_core_wait (
+    struct aura_reg_service *reg,
+    const struct asic_context *asic,
+    int channel,
+    struct aura_stats *stats
+){
+    ktime_t deadline;
+
+    if (!display_core_busy(reg, asic, channel))
+        return 0;
+
+    aura_stats_inc(stats, AURA_STAT_CONTENTION);
+    deadline = ktime_add_us(ktime_get(), DDC_I2C_ARBITRATION_WAIT);
+
+    do {
+        usleep_range(DDC_I2C_ARBITRATION_POLL, DDC_I2C_ARBITRATION_POLL * 2);
+
+        if (!display_core_busy(reg, asic, channel))
+            return 1;
+    } while (ktime_before(ktime_get(), deadline));
+
+    AURA_DBG("Display core still busy after %u us", DDC_I2C_ARBITRATION_WAIT);
+
+    return -EBUSY;
+}
+
+static void arbiter_withdraw (
+    struct aura_reg_service *reg,
+    const struct asic_context *asic
+){
+    reg_update_ex(reg, asic->i2c_registers->DC_I2C_ARBITRATION, (struct reg_fields[]){
+        /*
+            Hand the i2c registers back to the arbiter
+         */
+        ASIC_FIELDS(asic, DC_I2C_SW_USE_I2C_REG_REQ, 0),
+        ASIC_FIELDS(asic, DC_I2C_SW_DONE_USING_I2C_REG, 1),
+    }, 2);
+}
+
+/**
+ * aura_gpu_arbiter_acquire() - Claims the i2c registers for software
+ * @arbiter: Shared by both engines of the GPU
+ * @reg: Register access of the calling engine
+ * @asic: Register layout of the GPU
+ * @stats: Contention is counted here
+ *
+ * The first engine requests the registers from the hardware arbiter, the
+ * same way the display core does, and waits a bounded time for any transfer
+ * it has in flight. Touching either engine without the grant corrupts both
+ * transfers. While the grant is held, the other engine only counts itself in.
+ *
+ * @return: Zero when granted at once, one when the display core held the
+ *          block in between, or a negative error number
+ */
+int aura_gpu_arbiter_acquire (
+    struct aura_gpu_arbiter *arbiter,
+    struct aura_reg_service *reg,
+    const struct asic_context *asic,
+    struct aura_stats *stats
+){
+    int ret = 0;
+
+    mutex_lock(&arbiter->lock);
+
+    if (arbiter->users)
+        goto granted;
+
+    reg_update_ex(reg, asic->i2c_registers->DC_I2C_ARBITRATION, (struct reg_fields[]){
+        /*
+            Request software use of the i2c registers
+         */
+        ASIC_FIELDS(asic, DC_I2C_SW_USE_I2C_REG_REQ, 1),
+        ASIC_FIELDS(asic, DC_I2C_SW_DONE_USING_I2C_REG, 0),
+    }, 2);
+
+    ret = display_core_wait(reg, asic, -1, stats);
+    if (ret < 0) {
+        arbiter_withdraw(reg, asic);
+        mutex_unlock(&arbiter->lock);
+        return ret;
+    }
+
+granted:
+    arbiter->users++;
+    mutex_unlock(&arbiter->lock);
+
+    return ret;
+}
+
+/**
+ * aura_gpu_arbiter_release() - Drops a claim taken by aura_gpu_arbiter_acquire()
+ * @arbiter: Shared by both engines of the GPU
+ * @reg: Register access of the calling engine
+ * @asic: Register layout of the GPU
+ *
+ * The registers go back to the arbiter with the last claim.
+ */
+void aura_gpu_arbiter_release (
+    struct aura_gpu_arbiter *arbiter,
+    struct aura_reg_service *reg,
+    const struct asic_context *asic
+){
+    mutex_lock(&arbiter->lock);
+
+    if (!WARN_ON(!arbiter->users) && !--arbiter->users)
+        arbiter_withdraw(reg, asic);
+
+    mutex_unlock(&arbiter->lock);
+}
+
+
+static void set_speed (
+    struct aura_ddc_context *context,
+    uint32_t speed
+){
+    if (!speed || !context->reference_frequency)
+        return;
+
+    reg_update_ex(context->reg_service, context->registers->DC_I2C_DDC_SPEED[context->channel], (struct reg_fields[]){
+        /*
+            Same layout and timings as GENERIC_I2C_SPEED
+         */
+        PIN_FIELDS(context, DC_I2C_DDC1_PRESCALE, context->reference_frequency / speed),
+        PIN_FIELDS(context, DC_I2C_DDC1_THRESHOLD, 2),
+        PIN_FIELDS(context, DC_I2C_DDC1_START_STOP_TIMING_CNTL, speed > 50 ? 2 : 1),
+    }, 3);
+}
+
+static void configure_engine (
+    struct aura_ddc_context *context
+){
+    struct aura_reg_service *reg = context->reg_service;
+    const struct i2c_registers *regs = context->registers;
+
+    reg_update_ex(reg, regs->DC_I2C_DDC_SETUP[context->channel], (struct reg_fields[]){
+        /*
+            Power up the channel, leaving the pads open drain
+         */
+        PIN_FIELDS(context, DC_I2C_DDC1_ENABLE, 1),
+        PIN_FIELDS(context, DC_I2C_DDC1_TIME_LIMIT, DDC_I2C_TIME_LIMIT),
+        PIN_FIELDS(context, DC_I2C_DDC1_DATA_DRIVE_EN, 0),
+        PIN_FIELDS(context, DC_I2C_DDC1_CLK_DRIVE_EN, 0),
+        PIN_FIELDS(context, DC_I2C_DDC1_INTRA_BYTE_DELAY, 0),
+        PIN_FIELDS(context, DC_I2C_DDC1_INTRA_TRANSACTION_DELAY, 0),
+    }, 6);
+
+    reg_update_ex(reg, regs->DC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Route the engine to the channel and clear any status left
+            by the previous user
+         */
+        PIN_FIELDS(context, DC_I2C_GO, 0),
+        PIN_FIELDS(context, DC_I2C_SOFT_RESET, 0),
+        PIN_FIELDS(context, DC_I2C_SEND_RESET, 0),
+        PIN_FIELDS(context, DC_I2C_SW_STATUS_RESET, 1),
+        PIN_FIELDS(context, DC_I2C_TRANSACTION_COUNT, 0),
+        PIN_FIELDS(context, DC_I2C_DDC_SELECT, context->channel),
+    }, 6);
+
+    reg_update_ex(reg, regs->DC_I2C_ARBITRATION, (struct reg_fields[]){
+        /*
+            Let a GO issued while the hardware uses the channel start
+            once it is done
+         */
+        PIN_FIELDS(context, DC_I2C_NO_QUEUED_SW_GO, 0),
+    }, 1);
+
+    if (context->reference_frequency) {
+        context->original_speed = reg_read(reg, regs->DC_I2C_DDC_SPEED[context->channel]);
+        set_speed(context, context->speed);
+    }
+}
+
+static void release_engine (
+    struct aura_ddc_context *context
+){
+    struct aura_reg_service *reg = context->reg_service;
+    const struct i2c_registers *regs = context->registers;
+
+    if (context->reference_frequency)
+        reg_write(reg, regs->DC_I2C_DDC_SPEED[context->channel], context->original_speed);
+
+    reg_update_ex(reg, regs->DC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Clear our status, resetting the engine only when the last
+            transfer left it in an unknown state
+         */
+        PIN_FIELDS(context, DC_I2C_SOFT_RESET, context->faulted),
+        PIN_FIELDS(context, DC_I2C_SW_STATUS_RESET, 1),
+    }, 2);
+
+    if (context->faulted) {
+        reg_update_ex(reg, regs->DC_I2C_CONTROL, (struct reg_fields[]){
+            /*
+                Clear the reset flag
+             */
+            PIN_FIELDS(context, DC_I2C_SOFT_RESET, 0),
+        }, 1);
+    }
+
+    reg_update_ex(reg, regs->DC_I2C_DDC_SETUP[context->channel], (struct reg_fields[]){
+        /*
+            Clock gate the channel again
+         */
+        PIN_FIELDS(context, DC_I2C_DDC1_ENABLE, 0),
+    }, 1);
+
+    context->faulted = false;
+}
+
+static error_t open_engine (
+    struct aura_ddc_context *context
+){
+    int ret;
+
+    mutex_lock(&context->engine->lock);
+
+    ret = aura_gpu_arbiter_acquire(context->engine->arbiter, context->reg_service, context->asic, context->stats);
+    if (ret < 0)
+        goto error_unlock;
+
+    /* The grant does not cover the hardware requests on the channel */
+    ret = display_core_wait(context->reg_service, context->asic, context->channel, context->stats);
+    if (ret < 0)
+        goto error_release;
+
+    configure_engine(context);
+
+    return 0;
+
+error_release:
+    aura_gpu_arbiter_release(context->engine->arbiter, context->reg_service, context->asic);
+error_unlock:
+    mutex_unlock(&context->engine->lock);
+
+    return ret;
+}
+
+static void close_engine (
+    struct aura_ddc_context *context
+){
+    release_engine(context);
+
+    aura_gpu_arbiter_release(context->engine->arbiter, context->reg_service, context->asic);
+    mutex_unlock(&context->engine->lock);
+}
+
+
+/* A DC_I2C_DATA value carrying a single buffer byte */
+static inline uint32_t data_word (
+    const struct aura_ddc_context *context,
+    uint8_t byte
+){
+    return ((uint32_t)byte << context->shifts->DC_I2C_DATA) & context->masks->DC_I2C_DATA;
+}
+
+/*
+ * Each message becomes one transaction. Written bytes fill the buffer in
+ * order, each transaction starting with its address, and the bytes read
+ * are stored by the engine after them.
+ *
+ * @return: Number of buffer entries written
+ */
+static uint32_t process_transactions (
+    struct aura_ddc_context *context,
+    const struct i2c_msg *msgs,
+    int count,
+    bool stop
+){
+    struct aura_reg_service *reg = context->reg_service;
+    uint32_t words[DDC_I2C_BUFFER_SIZE];
+    uint32_t written = 0;
+    bool read;
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        read = msgs[i].flags & I2C_M_RD;
+
+        reg_set_ex(reg, context->registers->DC_I2C_TRANSACTION[i], 0, (struct reg_fields[]){
+            /*
+                Every transaction begins with a START, a repeated START
+                after the first. Only the last may send the STOP, without
+                it the next run continues with a repeated START.
+             */
+            PIN_FIELDS(context, DC_I2C_RW0, read),
+            PIN_FIELDS(context, DC_I2C_STOP_ON_NACK0, 1),
+            PIN_FIELDS(context, DC_I2C_ACK_ON_READ0, 0),
+            PIN_FIELDS(context, DC_I2C_START0, 1),
+            PIN_FIELDS(context, DC_I2C_STOP0, stop && i == count - 1),
+            PIN_FIELDS(context, DC_I2C_COUNT0, msgs[i].len),
+        }, 6);
+
+        words[written++] = data_word(context, (msgs[i].addr << 1) | read);
+
+        if (!read) {
+            for (j = 0; j < msgs[i].len; j++)
+                words[written++] = data_word(context, msgs[i].buf[j]);
+        }
+    }
+
+    /*
+        The first entry rewinds the buffer to index 0, the index then
+        auto-increments on each write to DC_I2C_DATA.
+     */
+    words[0] |= context->masks->DC_I2C_INDEX_WRITE;
+    reg_write_seq(reg, context->registers->DC_I2C_DATA, words, written);
+
+    return written;
+}
+
+static void execute_transactions (
+    struct aura_ddc_context *context,
+    int count
+){
+    struct aura_reg_service *reg = context->reg_service;
+
+    reg_update_ex(reg, context->registers->DC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Clear the previous run's status and set the number of
+            transactions, less one
+         */
+        PIN_FIELDS(context, DC_I2C_GO, 0),
+        PIN_FIELDS(context, DC_I2C_SW_STATUS_RESET, 1),
+        PIN_FIELDS(context, DC_I2C_TRANSACTION_COUNT, count - 1),
+    }, 3);
+
+    reg_update_ex(reg, context->registers->DC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Write 1 to start I2C transfer
+         */
+        PIN_FIELDS(context, DC_I2C_SW_STATUS_RESET, 0),
+        PIN_FIELDS(context, DC_I2C_GO, 1),
+    }, 2);
+}
+
+static error_t get_channel_status (
+    struct aura_ddc_context *context
+){
+    struct reg_fields status = PIN_FIELDS(context, DC_I2C_SW_STATUS, 0);
+    uint32_t value = reg_get_ex(context->reg_service, context->registers->DC_I2C_SW_STATUS, &status, 1);
+
+    if (status.value == DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_SW)
+        return -EBUSY;
+
+    if (value & context->masks->DC_I2C_SW_STOPPED_ON_NACK)
+        return -ENXIO;
+
+    if (value & context->masks->DC_I2C_SW_TIMEOUT)
+        return -ETIMEDOUT;
+
+    if (value & context->masks->DC_I2C_SW_ABORTED)
+        return -EIO;
+
+    /* Not started yet */
+    if (!(value & context->masks->DC_I2C_SW_DONE))
+        return -EBUSY;
+
+    return 0;
+}
+
+/*
+ * Sleeps for the modelled bus time of @length bytes, then checks the
+ * status at short intervals until the engine is done.
+ */
+static error_t poll_engine (
+    struct aura_ddc_context *context,
+    uint32_t length
+){
+    ktime_t start = ktime_get();
+    ktime_t deadline = ktime_add_us(start, DDC_I2C_TIMEOUT);
+    uint32_t expected = DIV_ROUND_UP((length * 9 + DDC_I2C_FRAMING_BITS) * 1000, context->speed);
+    error_t err;
+
+    usleep_range(expected, expected + expected / 4);
+
+    for (;;) {
+        err = get_channel_status(context);
+        if (err != -EBUSY)
+            break;
+
+        if (ktime_after(ktime_get(), deadline)) {
+            err = -ETIMEDOUT;
+            break;
+        }
+
+        usleep_range(DDC_I2C_POLL_INTERVAL, DDC_I2C_POLL_INTERVAL * 2);
+    }
+
+    aura_stats_time(context->stats, AURA_HIST_POLL, start);
+
+    return err;
+}
+
+/* Hands the bytes stored after the written entries to the read messages */
+static void process_reply (
+    struct aura_ddc_context *context,
+    struct i2c_msg *msgs,
+    int count,
+    uint32_t written,
+    uint32_t length
+){
+    struct aura_reg_service *reg = context->reg_service;
+    uint32_t words[DDC_I2C_BUFFER_SIZE];
+    uint32_t offset = 0;
+    int i, j;
+
+    reg_set_ex(reg, context->registers->DC_I2C_DATA, 0, (struct reg_fields[]){
+        /*
+            Select buffer reads from the first entry the engine filled,
+            the index auto-increments on each read of DC_I2C_DATA.
+         */
+        PIN_FIELDS(context, DC_I2C_DATA_RW, 1),
+        PIN_FIELDS(context, DC_I2C_INDEX, written),
+        PIN_FIELDS(context, DC_I2C_INDEX_WRITE, 1),
+    }, 3);
+
+    reg_read_seq(reg, context->registers->DC_I2C_DATA, words, length);
+
+    for (i = 0; i < count; i++) {
+        if (!(msgs[i].flags & I2C_M_RD))
+            continue;
+
+        for (j = 0; j < msgs[i].len; j++, offset++)
+            msgs[i].buf[j] = (words[offset] & context->masks->DC_I2C_DATA) >> context->shifts->DC_I2C_DATA;
+    }
+}
+
+static void account_result (
+    struct aura_ddc_context *context,
+    error_t err
+){
+    switch (err) {
+    case -ETIMEDOUT:
+        aura_stats_inc(context->stats, AURA_STAT_TIMEOUT);
+        break;
+    case -ENXIO:
+        aura_stats_inc(context->stats, AURA_STAT_NO_RESPONSE);
+        break;
+    case -EIO:
+        aura_stats_inc(context->stats, AURA_STAT_ABORTED);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Runs up to DC_I2C_MAX_TRANSACTIONS messages which fit the buffer together */
+static error_t submit_run (
+    struct aura_ddc_context *context,
+    struct i2c_msg *msgs,
+    int count,
+    bool stop
+){
+    uint32_t written, length = 0;
+    error_t err;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (msgs[i].flags & I2C_M_RD)
+            length += msgs[i].len;
+    }
+
+    written = process_transactions(context, msgs, count, stop);
+    execute_transactions(context, count);
+
+    err = poll_engine(context, written + length);
+    account_result(context, err);
+    if (err)
+        return err;
+
+    if (length)
+        process_reply(context, msgs, count, written, length);
+
+    return 0;
+}
+
+/*
+ * Packs consecutive messages into runs, all but the last leaving the bus
+ * held. A run ends with its first read, the usual index write followed by
+ * a read still shares one. Messages must fit the buffer with their address
+ * byte.
+ *
+ * The engine must already be open.
+ */
+static int __submit_messages (
+    struct aura_ddc_context *context,
+    struct i2c_msg *msgs,
+    int num
+){
+    uint32_t used;
+    error_t err;
+    int i, next;
+
+    for (i = 0; i < num; i++) {
+        if ((msgs[i].flags & I2C_M_NOSTART) || msgs[i].len + 1 > DDC_I2C_BUFFER_SIZE)
+            return -EOPNOTSUPP;
+    }
+
+    for (i = 0; i < num; i = next) {
+        used = 0;
+
+        for (next = i; next < num && next - i < DC_I2C_MAX_TRANSACTIONS; next++) {
+            if (used + msgs[next].len + 1 > DDC_I2C_BUFFER_SIZE)
+                break;
+
+            used += msgs[next].len + 1;
+
+            /*
+                The engine stores read data after every written entry
+                of the run, so nothing written may follow a read
+             */
+            if (msgs[next].flags & I2C_M_RD) {
+                next++;
+                break;
+            }
+        }
+
+        err = submit_run(context, &msgs[i], next - i, next == num);
+        if (err) {
+            /* The engine sends the STOP itself after a NACK */
+            if (err != -ENXIO)
+                context->faulted = true;
+
+            return err;
+        }
+    }
+
+    return num;
+}
+
+static int aura_ddc_xfer (
+    struct i2c_adapter *i2c_adapter,
+    struct i2c_msg *msgs,
+    int num
+){
+    struct aura_ddc_context *context = i2c_get_adapdata(i2c_adapter);
+    ktime_t start = ktime_get();
+    int ret;
+
+    if (IS_NULL(context))
+        return -EIO;
+
+    trace_aura_i2c_xfer_start(i2c_adapter, msgs, num);
+
+    ret = open_engine(context);
+    if (!ret) {
+        ret = __submit_messages(context, msgs, num);
+        close_engine(context);
+    }
+
+    trace_aura_i2c_xfer_end(i2c_adapter, num, ret);
+
+    if (num > 0)
+        aura_stats_xfer(context->stats, msgs[0].addr, num, aura_stats_msg_bytes(msgs, num), ret, start);
+
+    return ret;
+}
+
+static u32 aura_ddc_func (
+    struct i2c_adapter *adap
+){
+    /* SMBus is emulated, blocks would not fit the buffer */
+    return I2C_FUNC_I2C |
+           I2C_FUNC_SMBUS_QUICK |
+           I2C_FUNC_SMBUS_BYTE |
+           I2C_FUNC_SMBUS_BYTE_DATA |
+           I2C_FUNC_SMBUS_WORD_DATA;
+}
+
+static const struct i2c_algorithm aura_ddc_algo = {
+    .master_xfer   = aura_ddc_xfer,
+    .functionality = aura_ddc_func,
+};
+
+
+static error_t aura_ddc_queue_begin (
+    struct i2c_adapter *i2c_adapter
+){
+    return open_engine(i2c_get_adapdata(i2c_adapter));
+}
+
+static int aura_ddc_queue_xfer (
+    struct i2c_adapter *i2c_adapter,
+    struct i2c_msg *msgs,
+    int num
+){
+    struct aura_ddc_context *context = i2c_get_adapdata(i2c_adapter);
+    ktime_t start = ktime_get();
+    int ret;
+
+    trace_aura_i2c_xfer_start(i2c_adapter, msgs, num);
+    ret = __submit_messages(context, msgs, num);
+    trace_aura_i2c_xfer_end(i2c_adapter, num, ret);
+
+    if (num > 0)
+        aura_stats_xfer(context->stats, msgs[0].addr, num, aura_stats_msg_bytes(msgs, num), ret, start);
+
+    return ret;
+}
+
+static void aura_ddc_queue_end (
+    struct i2c_adapter *i2c_adapter
+){
+    close_engine(i2c_get_adapdata(i2c_adapter));
+}
+
+/* Queued requests are drained under a single open_engine/close_engine */
+static const struct aura_i2c_queue_ops aura_ddc_queue_ops = {
+    .begin = aura_ddc_queue_begin,
+    .xfer  = aura_ddc_queue_xfer,
+    .end   = aura_ddc_queue_end,
+};
+
+
+static struct aura_ddc_context *aura_ddc_context_create (
+    struct pci_dev *pci_dev,
+    const struct asic_context *asic,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
+){
+    struct aura_ddc_context *context;
+    error_t err;
+
+    context = kzalloc(sizeof(*context), GFP_KERNEL);
+    if (!context)
+        return ERR_PTR(-ENOMEM);
+
+    context->stats = aura_stats_create();
+    if (IS_ERR(context->stats)) {
+        err = PTR_ERR(context->stats);
+        goto error_free_context;
+    }
+
+    context->reg_service        = engine->resources->reg_service;
+    context->asic               = asic;
+    context->registers          = asic->i2c_registers;
+    context->masks              = asic->i2c_masks;
+    context->shifts             = asic->i2c_shifts;
+    context->engine             = engine;
+    context->channel            = line->channel;
+    context->speed              = DDC_I2C_DEFAULT_SPEED;
+    context->reference_frequency = engine->resources->reference_frequency;
+
+    context->i2c_adapter.owner  = THIS_MODULE;
+    context->i2c_adapter.class  = I2C_CLASS_DDC;
+    context->i2c_adapter.algo   = &aura_ddc_algo;
+
+    snprintf(context->i2c_adapter.name, sizeof(context->i2c_adapter.name), "AURA GPU adapter %s line %u", pci_name(pci_dev), line->number);
+    i2c_set_adapdata(&context->i2c_adapter, context);
+
+    err = i2c_add_adapter(&context->i2c_adapter);
+    if (err)
+        goto error_free_stats;
+
+    aura_stats_publish(context->stats, &context->i2c_adapter);
+
+    context->queue = aura_i2c_queue_create(&context->i2c_adapter, &aura_ddc_queue_ops);
+    if (IS_ERR(context->queue)) {
+        err = PTR_ERR(context->queue);
+        goto error_del_adapter;
+    }
+
+    return context;
+
+error_del_adapter:
+    i2c_del_adapter(&context->i2c_adapter);
+error_free_stats:
+    aura_stats_destroy(context->stats);
+error_free_context:
+    kfree(context);
+
+    return ERR_PTR(err);
+}
+
+void aura_ddc_adapter_destroy (
+    struct i2c_adapter *i2c_adapter
+){
+    struct aura_ddc_context *context = context_from_adapter(i2c_adapter);
+
+    if (IS_NULL(i2c_adapter))
+        return;
+
+    aura_i2c_queue_destroy(context->queue);
+    i2c_del_adapter(&context->i2c_adapter);
+
+    aura_stats_destroy(context->stats);
+    kfree(context);
+}
+
+/**
+ * aura_ddc_adapter_create() - Creates an adapter driving one DDC channel
+ * @pci_dev: The GPU
+ * @engine: The DC_I2C engine, shared by every DDC adapter of @pci_dev
+ * @line: A hardware assisted line, with its DDC channel
+ */
+struct i2c_adapter *aura_ddc_adapter_create (
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
+){
+    const struct pci_device_id *match;
+    const struct asic_context *asic;
+    struct aura_ddc_context *context;
+
+    if (IS_NULL(pci_dev, engine, line, engine->resources))
+        return ERR_PTR(-EINVAL);
+
+    if (!line->ddc || line->channel >= DC_I2C_DDC_COUNT)
+        return ERR_PTR(-ENODEV);
+
+    match = pci_match_id(pciidlist, pci_dev);
+    if (!match)
+        return ERR_PTR(-ENODEV);
+
+    asic = aura_gpu_i2c_get_ddc_context(match->driver_data);
+    if (!asic)
+        return ERR_PTR(-ENODEV);
+
+    context = aura_ddc_context_create(pci_dev, asic, engine, line);
+    if (IS_ERR(context))
+        return ERR_CAST(context);
+
+    return &context->i2c_adapter;
+}
@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _UAPI_AURA_GPU_DDC_H
+#define _UAPI_AURA_GPU_DDC_H
+
+#include <linux/i2c.h>
+#include <linux/pci.h>
+#include "aura-gpu-reg.h"
+#include "aura-gpu-stats.h"
+#include "aura-gpu-backend.h"
+#include "asic/asic-registers.h"
+
+int aura_gpu_arbiter_acquire (
+    struct aura_gpu_arbiter *arbiter,
+    struct aura_reg_service *reg,
+    const struct asic_context *asic,
+    struct aura_stats *stats
+);
+
+void aura_gpu_arbiter_release (
+    struct aura_gpu_arbiter *arbiter,
+    struct aura_reg_service *reg,
+    const struct asic_context *asic
+);
+
+struct i2c_adapter *aura_ddc_adapter_create (
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
+);
+
+void aura_ddc_adapter_destroy (
+    struct i2c_adapter *i2c_adapter
+);
+
+#endif
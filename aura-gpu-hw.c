@@ -2,10 +2,14 @@
 #include <linux/i2c.h>
 
 #include "debug.h"
-#include "pci_ids.h"
 #include "aura-gpu-hw.h"
 #include "aura-gpu-bios.h"
 #include "aura-gpu-reg.h"
+#include "aura-gpu-replay.h"
+#include "aura-gpu-trace.h"
+#include "aura-gpu-async.h"
+#include "aura-gpu-stats.h"
+#include "aura-gpu-backend.h"
 #include "atom/atom.h"
 
 struct ATOM_MASTER_LIST_OF_COMMAND_TABLES {
@@ -96,21 +100,48 @@ struct ATOM_MASTER_LIST_OF_COMMAND_TABLES {
     (((char*)(&((struct ATOM_MASTER_LIST_OF_##MasterOrData##_TABLES*)0)->FieldName)-(char*)0)/sizeof(uint16_t)) \
 )
 
-struct hw_i2c_context {
+#define I2C_PRESENCE_ADDRESSES          0x80
+#define I2C_PRESENCE_DEFAULT_TTL_MS     5000
+
+/* Used when the bios does not size the FB scratch area, as amdgpu does */
+#define ATOM_DEFAULT_SCRATCH_SIZE       (20 * 1024)
+
+/*
+ * One per GPU, shared by the adapters of all its lines. The atom mutex
+ * covers the context, its scratch and workspace, whichever line runs a
+ * table, and the replay cache tells lines apart by ucLineNumber.
+ */
+struct aura_gpu_interpreter {
     struct card_info        atom_card_info;
     struct atom_context     *atom_context;
     struct aura_reg_service *reg_service;
-    struct atom_bios        *bios;
+    struct aura_replay      *replay;
+};
+
+struct hw_i2c_context {
     struct i2c_adapter      adapter;
+    struct aura_i2c_queue   *queue;
+    struct aura_stats       *stats;
     bool                    registered;
-
-    uint8_t                 scratch[20 * 1024];
+    unsigned int            speed;
+
+    /* Shared with the adapters of the GPU's other lines */
+    struct aura_gpu_engine  *engine;
+    struct aura_gpu_interpreter *interpreter;
+    uint8_t                 line;
+
+    struct {
+        DECLARE_BITMAP(known, I2C_PRESENCE_ADDRESSES);
+        DECLARE_BITMAP(present, I2C_PRESENCE_ADDRESSES);
+        unsigned long       expires[I2C_PRESENCE_ADDRESSES];
+        unsigned int        ttl_ms;
+    } presence;
 };
 #define context_from_adapter(ptr) ( \
     container_of(ptr, struct hw_i2c_context, adapter) \
 )
-#define context_from_card(ptr) ( \
-    container_of(ptr, struct hw_i2c_context, atom_card_info) \
+#define interpreter_from_card(ptr) ( \
+    container_of(ptr, struct aura_gpu_interpreter, atom_card_info) \
 )
 
 static uint32_t __invalid_read (
@@ -133,13 +164,9 @@ static uint32_t mm_read (
     struct card_info *info,
     uint32_t reg
 ){
-    uint32_t res;
-    struct hw_i2c_context *ctx = context_from_card(info);
-
-    res = reg_read(ctx->reg_service, reg);
-    AURA_DBG("Read reg %x %x", reg, res);
+    struct aura_gpu_interpreter *interpreter = interpreter_from_card(info);
 
-    return res;
+    return reg_read(interpreter->reg_service, reg);
 }
 
 static void mm_write (
@@ -147,13 +174,15 @@ static void mm_write (
     uint32_t reg,
     uint32_t val
 ){
-    struct hw_i2c_context *ctx = context_from_card(info);
+    struct aura_gpu_interpreter *interpreter = interpreter_from_card(info);
 
-    AURA_DBG("Writing reg %x val %x", reg, val);
-    reg_write(ctx->reg_service, reg, val);
+    reg_write(interpreter->reg_service, reg, val);
 }
 
 #define TARGET_HW_I2C_CLOCK             50
+/* ucI2CSpeed is a single byte in kHz */
+#define MIN_HW_I2C_CLOCK                10
+#define MAX_HW_I2C_CLOCK                255
 #define ATOM_MAX_HW_I2C_WRITE           3
 #define ATOM_MAX_HW_I2C_READ            255
 #define HW_I2C_WRITE                    1
@@ -174,22 +203,97 @@ struct transaction_parameters {
     uint8_t     ucLineNumber;
 };
 
+/*
+ * Results of bus probes are cached per address. Any successful transaction
+ * marks the address present, any failed one forgets it again, so a client
+ * which stops responding is probed for real on the next scan.
+ */
+static void presence_mark (
+    struct hw_i2c_context *context,
+    uint8_t addr,
+    bool present
+){
+    if (addr >= I2C_PRESENCE_ADDRESSES || !context->presence.ttl_ms)
+        return;
+
+    if (present)
+        set_bit(addr, context->presence.present);
+    else
+        clear_bit(addr, context->presence.present);
+
+    context->presence.expires[addr] = jiffies + msecs_to_jiffies(context->presence.ttl_ms);
+    set_bit(addr, context->presence.known);
+}
+
+static void presence_forget (
+    struct hw_i2c_context *context,
+    uint8_t addr
+){
+    if (addr < I2C_PRESENCE_ADDRESSES)
+        clear_bit(addr, context->presence.known);
+}
+
+static bool presence_lookup (
+    struct hw_i2c_context *context,
+    uint8_t addr,
+    bool *present
+){
+    if (addr >= I2C_PRESENCE_ADDRESSES || !test_bit(addr, context->presence.known))
+        return false;
+
+    if (time_after(jiffies, context->presence.expires[addr])) {
+        clear_bit(addr, context->presence.known);
+        return false;
+    }
+
+    *present = test_bit(addr, context->presence.present);
+
+    return true;
+}
+
+/* Parameter bytes which carry data, everything else describes the transaction */
+#define TRANSACTION_DATA_BYTES ( \
+    BIT(offsetof(struct transaction_parameters, ucRegIndex)) | \
+    BIT(offsetof(struct transaction_parameters, lpI2CDataOut)) | \
+    BIT(offsetof(struct transaction_parameters, lpI2CDataOut) + 1) \
+)
+
+/*
+ * The write variant carries the register index in ucRegIndex and at most two
+ * further data bytes packed into lpI2CDataOut. The read variant returns its
+ * data through the scratch (FB) window, which the table fills from offset 0.
+ */
+#define ATOM_MAX_HW_I2C_WRITE_DATA      (ATOM_MAX_HW_I2C_WRITE - 1)
+
 static error_t aura_gpu_i2c_process_i2c_ch(
     struct hw_i2c_context *context,
     uint8_t slave_addr,
     uint8_t offset,
     uint8_t flags,
-    uint8_t *buf
+    uint8_t *buf,
+    uint8_t count
 ){
     struct transaction_parameters args;
-    int index = GetIndexIntoMasterTable(COMMAND, ProcessI2cChannelTransaction);
+    uint16_t out = 0;
+    ktime_t start;
     error_t err = 0;
 
     memset(&args, 0, sizeof(args));
 
     if (flags & HW_I2C_WRITE) {
-        args.lpI2CDataOut = buf ? cpu_to_le16(*buf) : 0;
-    } else if (!buf) {
+        if (count > ATOM_MAX_HW_I2C_WRITE_DATA) {
+            err = -EINVAL;
+            goto done;
+        }
+
+        if (buf && count > 0)
+            out |= buf[0];
+        if (buf && count > 1)
+            out |= buf[1] << 8;
+
+        args.lpI2CDataOut = cpu_to_le16(out);
+    } else if (!buf || !count || count > ATOM_MAX_HW_I2C_READ ||
+               count > context->interpreter->atom_context->scratch_size_bytes) {
         err = -EINVAL;
         goto done;
     } else {
@@ -197,180 +301,558 @@ static error_t aura_gpu_i2c_process_i2c_ch(
     }
 
     args.ucFlag = flags;
-    args.ucI2CSpeed = TARGET_HW_I2C_CLOCK;
-    args.ucTransBytes = 1;
+    args.ucI2CSpeed = READ_ONCE(context->speed);
+    args.ucTransBytes = count;
     args.ucSlaveAddr = slave_addr << 1;
     args.ucRegIndex = offset;
-    args.ucLineNumber = 6;
-
-    AURA_DBG("Pre Transaction: addr = %x, offset = %x, rw = %s, count = %d, out = %x",
-        args.ucSlaveAddr >> 1,
-        offset,
-        args.ucFlag == HW_I2C_READ ? "r" : "w",
-        args.ucTransBytes,
-        args.lpI2CDataOut
-    );
-
-    atom_execute_table(context->atom_context, index, (uint32_t *)&args);
+    args.ucLineNumber = context->line;
+
+    /*
+        The table drives the same engine whichever line it selects. The
+        scratch is shared with the other lines too, so the data is copied
+        out before another line can run the table.
+     */
+    mutex_lock(&context->engine->lock);
+    start = ktime_get();
+    aura_replay_execute(context->interpreter->replay, (uint32_t *)&args);
+
+    if (!(flags & HW_I2C_WRITE) && args.ucStatus == HW_ASSISTED_I2C_STATUS_SUCCESS) {
+        if (context->interpreter->atom_context->scratch)
+            memcpy(buf, context->interpreter->atom_context->scratch, count);
+        else
+            memset(buf, 0, count);
+    }
 
-    AURA_DBG(
-        "Post Transaction: status = %x, read = %x",
-        args.ucStatus,
-        args.lpI2CDataOut
-    );
+    mutex_unlock(&context->engine->lock);
+    aura_stats_time(context->stats, AURA_HIST_BIOS_TRANSACTION, start);
+    aura_stats_inc(context->stats, AURA_STAT_BIOS_TRANSACTIONS);
 
     /* error */
     if (args.ucStatus != HW_ASSISTED_I2C_STATUS_SUCCESS) {
-        AURA_DBG("hw_i2c error %x", args.ucStatus);
+        aura_stats_inc(context->stats, AURA_STAT_BIOS_FAILURE);
+        presence_forget(context, slave_addr);
         err = -EIO;
         goto done;
     }
 
-    if (!(flags & HW_I2C_WRITE)) {
-        *buf = (uint8_t)args.lpI2CDataOut;
-    }
+    presence_mark(context, slave_addr, true);
 
 done:
     return err;
 }
 
-#define dump_i2c_msg(num, msg) ({ \
-    AURA_DBG( \
-        "Message %d addr = %x, len = %d, flags = %x, data = %x %x", \
-        (num), \
-        (msg).addr, \
-        (msg).len, \
-        (msg).flags, \
-        (msg).buf[0], \
-        (msg).buf[1] \
-    ); \
-})
+/**
+ * aura_gpu_i2c_process_chunked() - Transfers a buffer in as few table runs as possible
+ * @context: Adapter context
+ * @slave_addr: 7 bit device address
+ * @offset: Register index of the first byte
+ * @flags: HW_I2C_READ or HW_I2C_WRITE
+ * @buf: Data buffer
+ * @len: Number of bytes in @buf
+ *
+ * Each chunk re-sends the register index, which is advanced by the chunk size
+ * so the device sees the same sequence of register accesses as before.
+ */
+static error_t aura_gpu_i2c_process_chunked(
+    struct hw_i2c_context *context,
+    uint8_t slave_addr,
+    uint8_t offset,
+    uint8_t flags,
+    uint8_t *buf,
+    int len
+){
+    int max_bytes = (flags & HW_I2C_WRITE) ? ATOM_MAX_HW_I2C_WRITE_DATA : ATOM_MAX_HW_I2C_READ;
+    int count;
+    error_t err;
 
-static int aura_gpu_i2c_xfer(
+    max_bytes = min_t(int, max_bytes, context->interpreter->atom_context->scratch_size_bytes);
+
+    while (len) {
+        count = min(len, max_bytes);
+
+        err = aura_gpu_i2c_process_i2c_ch(
+            context,
+            slave_addr,
+            offset,
+            flags,
+            buf,
+            count
+        );
+
+        if (err)
+            return err;
+
+        offset += count;
+        buf += count;
+        len -= count;
+    }
+
+    return 0;
+}
+
+static error_t aura_gpu_i2c_probe(
+    struct hw_i2c_context *context,
+    uint8_t slave_addr
+){
+    bool present;
+    error_t err;
+
+    if (presence_lookup(context, slave_addr, &present)) {
+        aura_stats_inc(context->stats, AURA_STAT_PROBE_CACHE_HITS);
+        return present ? 0 : -EIO;
+    }
+
+    err = aura_gpu_i2c_process_i2c_ch(context, slave_addr, 0, HW_I2C_WRITE, NULL, 0);
+    if (err)
+        presence_mark(context, slave_addr, false);
+
+    return err;
+}
+
+/**
+ * aura_gpu_i2c_read_block() - Performs an SMBus style block read
+ * @context: Adapter context
+ * @slave_addr: 7 bit device address
+ * @offset: Register index of the count byte
+ * @buf: Buffer of at least I2C_SMBUS_BLOCK_MAX + @extra bytes
+ * @extra: Bytes to read in addition to the block, including the count
+ *
+ * The first byte holds the number of bytes which follow. Every transaction
+ * restarts at @offset, so the count is read again along with the block.
+ *
+ * @return: The block length or a negative error number
+ */
+static int aura_gpu_i2c_read_block(
+    struct hw_i2c_context *context,
+    uint8_t slave_addr,
+    uint8_t offset,
+    uint8_t *buf,
+    int extra
+){
+    uint8_t count;
+    error_t err;
+
+    err = aura_gpu_i2c_process_i2c_ch(context, slave_addr, offset, HW_I2C_READ, &count, 1);
+    if (err)
+        return err;
+
+    if (count == 0 || count > I2C_SMBUS_BLOCK_MAX)
+        return -EPROTO;
+
+    err = aura_gpu_i2c_process_chunked(context, slave_addr, offset, HW_I2C_READ, buf, count + extra);
+    if (err)
+        return err;
+
+    if (buf[0] != count)
+        return -EPROTO;
+
+    return count;
+}
+
+static error_t aura_gpu_i2c_read_msg(
+    struct hw_i2c_context *context,
+    struct i2c_msg *msg,
+    uint8_t offset
+){
+    int count;
+
+    if (!(msg->flags & I2C_M_RECV_LEN))
+        return aura_gpu_i2c_process_chunked(context, msg->addr, offset, HW_I2C_READ, msg->buf, msg->len);
+
+    /* The caller sized msg->len for the count and PEC bytes */
+    count = aura_gpu_i2c_read_block(context, msg->addr, offset, msg->buf, msg->len);
+    if (count < 0)
+        return count;
+
+    msg->len += count;
+
+    return 0;
+}
+
+/*
+ * ProcessI2cChannelTransaction only knows two shapes, a register write
+ * (index followed by data) and a register read (index, repeated start,
+ * then data). Every message is mapped onto those:
+ *
+ *  - A zero length message is a probe.
+ *  - A write is an index followed by data, chunked as needed.
+ *  - A single byte write followed by a read of the same device only sets
+ *    the index, which the read transaction sends itself.
+ *  - A read uses the index the device is expected to be at, that is the
+ *    last index written plus the bytes transferred since.
+ *
+ * A read which no write to the same device precedes has no index, and the
+ * table would write one of its own, so such transfers are refused.
+ */
+static error_t aura_gpu_i2c_check_msgs(
+    struct i2c_msg *msgs,
+    int num
+){
+    bool indexed = false;
+    int address = -1;
+    int i;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].flags & I2C_M_TEN)
+            return -EOPNOTSUPP;
+
+        if (msgs[i].addr != address) {
+            address = msgs[i].addr;
+            indexed = false;
+        }
+
+        /* Zero length messages are probes and leave the index alone */
+        if (msgs[i].len == 0 && !(msgs[i].flags & I2C_M_RECV_LEN))
+            continue;
+
+        if (!(msgs[i].flags & I2C_M_RD))
+            indexed = true;
+        else if (!indexed)
+            return -EOPNOTSUPP;
+    }
+
+    return 0;
+}
+
+static int __aura_gpu_i2c_xfer(
     struct i2c_adapter *i2c_adap,
     struct i2c_msg *msgs,
     int num
 ){
     struct hw_i2c_context *context = i2c_get_adapdata(i2c_adap);
-    int remaining, buffer_offset;
-    uint8_t flags;
-    uint8_t offset;
-    uint8_t address;
+    struct i2c_msg *msg, *next;
+    int address = -1;
+    uint8_t offset = 0;
     error_t err;
     int i;
 
-    /* check for bus probe */
-    if ((num == 1) && (msgs[0].len == 0)) {
-        if (msgs[0].len == 0) {
-            // AURA_DBG("Bus probe detected %x", msgs[0].addr);
-            err = aura_gpu_i2c_process_i2c_ch(
-                context,
-                msgs[0].addr,
-                0,
-                HW_I2C_WRITE,
-                NULL
-            );
-        }
+    err = aura_gpu_i2c_check_msgs(msgs, num);
+    if (err)
+        return err;
+
+    for (i = 0; i < num; i++) {
+        msg = &msgs[i];
+        next = (i + 1 < num) ? &msgs[i + 1] : NULL;
 
-        return err ? err : num;
-    } else if ((num == 1) && (msgs[0].len > 1) && !(msgs[0].flags & I2C_M_RD)) {
-        // The first data byte should be the offset, remainder are the values
-        offset = msgs[0].buf[0];
-        address = msgs[0].addr;
-        remaining = msgs[0].len - 1;
-        buffer_offset = 1;
+        if (msg->addr != address) {
+            address = msg->addr;
+            offset = 0;
+        }
 
-        while (remaining) {
-            err = aura_gpu_i2c_process_i2c_ch(
+        if (msg->len == 0 && !(msg->flags & I2C_M_RECV_LEN)) {
+            err = aura_gpu_i2c_probe(context, msg->addr);
+        } else if (msg->flags & I2C_M_RD) {
+            err = aura_gpu_i2c_read_msg(context, msg, offset);
+            offset += msg->len;
+        } else if (msg->len > 1) {
+            offset = msg->buf[0];
+            err = aura_gpu_i2c_process_chunked(
                 context,
-                address,
+                msg->addr,
                 offset,
                 HW_I2C_WRITE,
-                &msgs[0].buf[buffer_offset]
+                &msg->buf[1],
+                msg->len - 1
             );
-
-            if (err)
-                return err;
-
-            offset++;
-            remaining--;
-            buffer_offset++;
-        }
-    } else if (num == 2) {
-        // The first message should be to set the offset
-        if (!(msgs[0].flags & I2C_M_RD) && msgs[0].len == 1) {
-            offset = msgs[0].buf[0];
-            address = msgs[0].addr;
+            offset += msg->len - 1;
         } else {
-            return -EIO;
+            offset = msg->buf[0];
+            if (next && (next->flags & I2C_M_RD) && next->addr == msg->addr)
+                continue;
+
+            err = aura_gpu_i2c_process_i2c_ch(context, msg->addr, offset, HW_I2C_WRITE, NULL, 0);
         }
 
-        // The second message should describe how many bytes to read/write
-        remaining = msgs[1].len;
-        buffer_offset = 0;
-        flags = (msgs[1].flags & I2C_M_RD) ? HW_I2C_READ : HW_I2C_WRITE;
+        if (err)
+            return err;
+    }
 
-        while (remaining) {
-            err = aura_gpu_i2c_process_i2c_ch(
-                context,
-                address,
-                offset,
-                flags,
-                &msgs[1].buf[buffer_offset]
-            );
+    return num;
+}
 
-            if (err)
-                return err;
+static int aura_gpu_i2c_xfer(
+    struct i2c_adapter *i2c_adap,
+    struct i2c_msg *msgs,
+    int num
+){
+    struct hw_i2c_context *context = i2c_get_adapdata(i2c_adap);
+    ktime_t start = ktime_get();
+    int ret;
+
+    trace_aura_i2c_xfer_start(i2c_adap, msgs, num);
+    ret = __aura_gpu_i2c_xfer(i2c_adap, msgs, num);
+    trace_aura_i2c_xfer_end(i2c_adap, num, ret);
+
+    if (context && num > 0)
+        aura_stats_xfer(context->stats, msgs[0].addr, num, aura_stats_msg_bytes(msgs, num), ret, start);
 
-            offset++;
-            remaining--;
-            buffer_offset++;
+    return ret;
+}
+
+/*
+ * SMBus commands map directly onto a single channel transaction, or a
+ * chunked run of them for blocks, skipping the message planner.
+ */
+static int __aura_gpu_i2c_smbus_xfer(
+    struct i2c_adapter *i2c_adap,
+    uint16_t addr,
+    unsigned short flags,
+    char read_write,
+    uint8_t command,
+    int size,
+    union i2c_smbus_data *data
+){
+    struct hw_i2c_context *context = i2c_get_adapdata(i2c_adap);
+    uint8_t rw = (read_write == I2C_SMBUS_READ) ? HW_I2C_READ : HW_I2C_WRITE;
+    uint8_t buf[2];
+    int count;
+    error_t err;
+
+    if (flags & I2C_CLIENT_PEC)
+        return -EOPNOTSUPP;
+
+    switch (size) {
+    case I2C_SMBUS_QUICK:
+        err = aura_gpu_i2c_probe(context, addr);
+        break;
+    case I2C_SMBUS_BYTE:
+        /* Every table read sends an index first, so a bare receive is impossible */
+        if (rw == HW_I2C_READ)
+            return -EOPNOTSUPP;
+
+        err = aura_gpu_i2c_process_i2c_ch(context, addr, command, HW_I2C_WRITE, NULL, 0);
+        break;
+    case I2C_SMBUS_BYTE_DATA:
+        err = aura_gpu_i2c_process_i2c_ch(context, addr, command, rw, &data->byte, 1);
+        break;
+    case I2C_SMBUS_WORD_DATA:
+        buf[0] = data->word & 0xff;
+        buf[1] = data->word >> 8;
+
+        err = aura_gpu_i2c_process_i2c_ch(context, addr, command, rw, buf, 2);
+        if (!err && rw == HW_I2C_READ)
+            data->word = buf[0] | (buf[1] << 8);
+        break;
+    case I2C_SMBUS_BLOCK_DATA:
+        if (rw == HW_I2C_READ) {
+            count = aura_gpu_i2c_read_block(context, addr, command, data->block, 1);
+            err = count < 0 ? count : 0;
+            break;
         }
-    } else {
-        AURA_DBG("Failed to process messages");
-        for (i = 0; i < num; i++)
-            dump_i2c_msg(i, msgs[i]);
 
-        return -EIO;
+        if (data->block[0] == 0 || data->block[0] > I2C_SMBUS_BLOCK_MAX)
+            return -EINVAL;
+
+        /* The count and the data must go out in a single table run */
+        if (data->block[0] + 1 > ATOM_MAX_HW_I2C_WRITE_DATA)
+            return -EOPNOTSUPP;
+
+        err = aura_gpu_i2c_process_i2c_ch(context, addr, command, rw, data->block, data->block[0] + 1);
+        break;
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        if (data->block[0] == 0 || data->block[0] > I2C_SMBUS_BLOCK_MAX)
+            return -EINVAL;
+
+        /* Further runs would re-send the index, which is not one block */
+        if (rw == HW_I2C_WRITE && data->block[0] > ATOM_MAX_HW_I2C_WRITE_DATA)
+            return -EOPNOTSUPP;
+
+        err = aura_gpu_i2c_process_chunked(context, addr, command, rw, &data->block[1], data->block[0]);
+        break;
+    default:
+        return -EOPNOTSUPP;
     }
 
-    return num;
+    return err;
+}
+
+static int aura_gpu_i2c_smbus_xfer(
+    struct i2c_adapter *i2c_adap,
+    uint16_t addr,
+    unsigned short flags,
+    char read_write,
+    uint8_t command,
+    int size,
+    union i2c_smbus_data *data
+){
+    struct hw_i2c_context *context = i2c_get_adapdata(i2c_adap);
+    ktime_t start = ktime_get();
+    int ret;
+
+    ret = __aura_gpu_i2c_smbus_xfer(i2c_adap, addr, flags, read_write, command, size, data);
+
+    /* The core retries unsupported commands through master_xfer, which counts them */
+    if (context && ret != -EOPNOTSUPP)
+        aura_stats_xfer(context->stats, addr, 0, aura_stats_smbus_bytes(size, data), ret, start);
+
+    return ret;
 }
 
 static uint32_t aura_gpu_i2c_func(
     struct i2c_adapter *adap
 ){
-    return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+    return I2C_FUNC_I2C |
+           I2C_FUNC_SMBUS_QUICK |
+           I2C_FUNC_SMBUS_WRITE_BYTE |
+           I2C_FUNC_SMBUS_BYTE_DATA |
+           I2C_FUNC_SMBUS_WORD_DATA |
+           I2C_FUNC_SMBUS_READ_BLOCK_DATA |
+           I2C_FUNC_SMBUS_READ_I2C_BLOCK;
 }
 
 static const struct i2c_algorithm aura_gpu_i2c_algo = {
     .master_xfer = aura_gpu_i2c_xfer,
+    .smbus_xfer = aura_gpu_i2c_smbus_xfer,
     .functionality = aura_gpu_i2c_func,
 };
 
 
-static void aura_gpu_i2c_destroy (
-    struct hw_i2c_context *context
+static const struct aura_i2c_queue_ops aura_gpu_i2c_queue_ops = {
+    .xfer = aura_gpu_i2c_xfer,
+};
+
+/* Number of table calls which had to fall back to allocating their workspace */
+static ssize_t atom_ws_heap_allocs_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
 ){
-    if (context->bios)
-        atom_bios_release(context->bios);
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
 
-    if (context->reg_service)
-        aura_gpu_reg_destroy(context->reg_service);
+    return sprintf(buf, "%lu\n", READ_ONCE(context->interpreter->atom_context->ws_heap_allocs));
+}
+static DEVICE_ATTR_RO(atom_ws_heap_allocs);
 
-    if (context->atom_context)
-        atom_destroy(context->atom_context);
+/* Every address currently known to respond, as a bitmap list */
+static ssize_t present_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
+){
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+    DECLARE_BITMAP(present, I2C_PRESENCE_ADDRESSES);
+    bool found;
+    int addr;
+
+    bitmap_zero(present, I2C_PRESENCE_ADDRESSES);
+    for (addr = 0; addr < I2C_PRESENCE_ADDRESSES; addr++) {
+        if (presence_lookup(context, addr, &found) && found)
+            set_bit(addr, present);
+    }
 
+    return sprintf(buf, "%*pbl\n", I2C_PRESENCE_ADDRESSES, present);
+}
+static DEVICE_ATTR_RO(present);
+
+static ssize_t probe_ttl_ms_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
+){
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+
+    return sprintf(buf, "%u\n", context->presence.ttl_ms);
+}
+
+/* Writing 0 disables the cache, any write drops what is cached */
+static ssize_t probe_ttl_ms_store (
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count
+){
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+    unsigned int ttl;
+    error_t err;
+
+    err = kstrtouint(buf, 0, &ttl);
+    if (err)
+        return err;
+
+    context->presence.ttl_ms = ttl;
+    bitmap_zero(context->presence.known, I2C_PRESENCE_ADDRESSES);
+
+    return count;
+}
+static DEVICE_ATTR_RW(probe_ttl_ms);
+
+static ssize_t speed_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
+){
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+
+    return sprintf(buf, "%u\n", READ_ONCE(context->speed));
+}
+
+/* Bus speed in kHz handed to the transaction table */
+static ssize_t speed_store (
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count
+){
+    struct hw_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+    unsigned int speed;
+    error_t err;
+
+    err = kstrtouint(buf, 0, &speed);
+    if (err)
+        return err;
+
+    if (speed < MIN_HW_I2C_CLOCK || speed > MAX_HW_I2C_CLOCK)
+        return -EINVAL;
+
+    WRITE_ONCE(context->speed, speed);
+
+    return count;
+}
+static DEVICE_ATTR_RW(speed);
+
+static struct attribute *aura_gpu_i2c_attrs[] = {
+    &dev_attr_atom_ws_heap_allocs.attr,
+    &dev_attr_speed.attr,
+    &dev_attr_present.attr,
+    &dev_attr_probe_ttl_ms.attr,
+    NULL
+};
+ATTRIBUTE_GROUPS(aura_gpu_i2c);
+
+static int aura_gpu_i2c_scratch_size (
+    struct atom_bios *bios
+){
+    uint32_t size = 0;
+
+    if (atom_bios_get_scratch_size(bios, &size) || size == 0)
+        return ATOM_DEFAULT_SCRATCH_SIZE;
+
+    /* The read variant copies its result from offset 0 */
+    return max_t(uint32_t, size, ATOM_MAX_HW_I2C_READ);
+}
+
+static void aura_gpu_i2c_destroy (
+    struct hw_i2c_context *context
+){
+    if (context->queue)
+        aura_i2c_queue_destroy(context->queue);
+
+    /* Nothing can reach the hardware once the adapter is gone */
     if (context->registered) {
         i2c_set_adapdata(&context->adapter, NULL);
         i2c_del_adapter(&context->adapter);
     }
 
+    if (context->stats)
+        aura_stats_destroy(context->stats);
+
     kfree(context);
 }
 
 static struct hw_i2c_context *aura_gpu_i2c_create (
-    struct pci_dev *pci_dev
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    uint8_t line
 ){
     error_t err;
     struct hw_i2c_context *context = kzalloc(sizeof(*context), GFP_KERNEL);
@@ -378,50 +860,39 @@ static struct hw_i2c_context *aura_gpu_i2c_create (
     if (!context)
         return ERR_PTR(-ENOMEM);
 
-    context->bios = atom_bios_create(pci_dev);
-    if (IS_ERR_OR_NULL(context->bios)) {
-        err = CLEAR_ERR(context->bios);
-        goto error_free_all;
-    }
+    context->engine = engine;
+    context->line = line;
+    context->interpreter = engine->resources->interpreter;
 
-    context->reg_service = aura_gpu_reg_create(pci_dev);
-    if (IS_ERR_OR_NULL(context->reg_service)) {
-        err = CLEAR_ERR(context->reg_service);
+    context->stats = aura_stats_create();
+    if (IS_ERR(context->stats)) {
+        err = CLEAR_ERR(context->stats);
         goto error_free_all;
     }
 
-    context->atom_card_info.reg_read    = mm_read;
-    context->atom_card_info.reg_write   = mm_write;
-
-    context->atom_card_info.ioreg_read  = __invalid_read;
-    context->atom_card_info.ioreg_write = __invalid_write;
-    context->atom_card_info.mc_read     = __invalid_read;
-    context->atom_card_info.mc_write    = __invalid_write;
-    context->atom_card_info.pll_read    = __invalid_read;
-    context->atom_card_info.pll_write   = __invalid_write;
-
-    context->atom_context = atom_parse(&context->atom_card_info, context->bios->data);
-    if (!context->atom_context) {
-        kfree(context);
-        return ERR_PTR(-ENOMEM);
-    }
-
-    mutex_init(&context->atom_context->mutex);
-    context->atom_context->scratch = (uint32_t*)context->scratch;
-    context->atom_context->scratch_size_bytes = sizeof(context->scratch);
+    context->presence.ttl_ms = I2C_PRESENCE_DEFAULT_TTL_MS;
+    context->speed = TARGET_HW_I2C_CLOCK;
     context->adapter.owner = THIS_MODULE;
     context->adapter.class = I2C_CLASS_DDC;
 
     i2c_set_adapdata(&context->adapter, context);
 
-    snprintf(context->adapter.name, sizeof(context->adapter.name), "AURA GPU adapter");
+    snprintf(context->adapter.name, sizeof(context->adapter.name), "AURA GPU adapter %s line %u", pci_name(pci_dev), line);
     context->adapter.algo = &aura_gpu_i2c_algo;
+    context->adapter.dev.groups = aura_gpu_i2c_groups;
 
     err = i2c_add_adapter(&context->adapter);
     if (err)
         goto error_free_all;
 
     context->registered = true;
+    aura_stats_publish(context->stats, &context->adapter);
+
+    context->queue = aura_i2c_queue_create(&context->adapter, &aura_gpu_i2c_queue_ops);
+    if (IS_ERR(context->queue)) {
+        err = CLEAR_ERR(context->queue);
+        goto error_free_all;
+    }
 
     return context;
 
@@ -431,33 +902,109 @@ error_free_all:
     return ERR_PTR(err);
 }
 
-static struct pci_dev *find_pci_dev (
-    void
+/**
+ * aura_i2c_bios_interpreter_destroy() - Frees an interpreter once no adapter uses it
+ * @interpreter: Created by aura_i2c_bios_interpreter_create()
+ */
+void aura_i2c_bios_interpreter_destroy (
+    struct aura_gpu_interpreter *interpreter
+){
+    if (IS_NULL(interpreter))
+        return;
+
+    if (interpreter->replay)
+        aura_replay_destroy(interpreter->replay);
+
+    if (interpreter->atom_context)
+        atom_destroy(interpreter->atom_context);
+
+    kfree(interpreter);
+}
+
+/**
+ * aura_i2c_bios_interpreter_create() - Parses a GPU's bios for its adapters
+ * @resources: The GPU's bios and register access, which must outlive the result
+ *
+ * The atom context, with its scratch, and the replay cache are shared by
+ * the bios adapters of every line.
+ *
+ * @return: The interpreter or an ERR_PTR
+ */
+struct aura_gpu_interpreter *aura_i2c_bios_interpreter_create (
+    const struct aura_gpu_resources *resources
 ){
-    struct pci_dev *pci_dev = NULL;
-    const struct pci_device_id *match;
+    struct aura_gpu_interpreter *interpreter;
+    error_t err;
+
+    if (IS_NULL(resources, resources->reg_service))
+        return ERR_PTR(-EINVAL);
+
+    if (!resources->bios)
+        return ERR_PTR(-ENODEV);
+
+    interpreter = kzalloc(sizeof(*interpreter), GFP_KERNEL);
+    if (!interpreter)
+        return ERR_PTR(-ENOMEM);
 
-    while (NULL != (pci_dev = pci_get_device(PCI_ANY_ID, PCI_ANY_ID, pci_dev))) {
-        match = pci_match_id(pciidlist, pci_dev);
-        if (match)
-            return pci_dev;
+    interpreter->reg_service = resources->reg_service;
+
+    interpreter->atom_card_info.reg_read    = mm_read;
+    interpreter->atom_card_info.reg_write   = mm_write;
+
+    interpreter->atom_card_info.ioreg_read  = __invalid_read;
+    interpreter->atom_card_info.ioreg_write = __invalid_write;
+    interpreter->atom_card_info.mc_read     = __invalid_read;
+    interpreter->atom_card_info.mc_write    = __invalid_write;
+    interpreter->atom_card_info.pll_read    = __invalid_read;
+    interpreter->atom_card_info.pll_write   = __invalid_write;
+
+    interpreter->atom_context = atom_parse(&interpreter->atom_card_info, resources->bios->data);
+    if (!interpreter->atom_context) {
+        err = -ENOMEM;
+        goto error_free_all;
+    }
+
+    mutex_init(&interpreter->atom_context->mutex);
+    interpreter->atom_context->scratch_size_bytes = aura_gpu_i2c_scratch_size(resources->bios);
+
+    interpreter->replay = aura_replay_create(
+        interpreter->atom_context,
+        GetIndexIntoMasterTable(COMMAND, ProcessI2cChannelTransaction),
+        sizeof(struct transaction_parameters),
+        TRANSACTION_DATA_BYTES,
+        offsetof(struct transaction_parameters, ucStatus),
+        HW_ASSISTED_I2C_STATUS_FAILURE
+    );
+    if (IS_ERR_OR_NULL(interpreter->replay)) {
+        err = CLEAR_ERR(interpreter->replay);
+        goto error_free_all;
     }
 
-    return NULL;
+    return interpreter;
+
+error_free_all:
+    aura_i2c_bios_interpreter_destroy(interpreter);
+
+    return ERR_PTR(err);
 }
 
+/**
+ * aura_i2c_bios_create() - Creates an adapter driving one line through the bios
+ * @pci_dev: The GPU
+ * @engine: Shared by every adapter of @pci_dev
+ * @line: The line to drive
+ */
 struct i2c_adapter *aura_i2c_bios_create (
-    void
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
 ){
-    struct pci_dev *pci_dev = find_pci_dev();
     struct hw_i2c_context *context;
 
-    if (!pci_dev) {
-        AURA_ERR("Failed to find a valid pci device");
-        return NULL;
-    }
+    if (IS_NULL(pci_dev, engine, line, engine->resources->interpreter))
+        return ERR_PTR(-EINVAL);
 
-    context = aura_gpu_i2c_create(pci_dev);
+    context = aura_gpu_i2c_create(pci_dev, engine, line->number);
     if (IS_ERR_OR_NULL(context))
         return ERR_PTR(CLEAR_ERR(context));
 
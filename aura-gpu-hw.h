@@ -2,13 +2,25 @@
 #define _UAPI_AURA_GPU_HW_I2C_H
 
 #include <linux/i2c.h>
+#include <linux/pci.h>
+#include "aura-gpu-backend.h"
 
 struct i2c_adapter *aura_i2c_bios_create (
-    void
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
 );
 
 void aura_i2c_bios_destroy (
     struct i2c_adapter *i2c_adapter
 );
 
+struct aura_gpu_interpreter *aura_i2c_bios_interpreter_create (
+    const struct aura_gpu_resources *resources
+);
+
+void aura_i2c_bios_interpreter_destroy (
+    struct aura_gpu_interpreter *interpreter
+);
+
 #endif
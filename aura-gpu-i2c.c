@@ -1,18 +1,53 @@
 // SPDX-License-Identifier: GPL-2.0
 #include <linux/i2c.h>
+#include <linux/completion.h>
 #include <linux/delay.h>
+#include <linux/hrtimer.h>
+#include <linux/interrupt.h>
+#include <linux/math64.h>
+#include <linux/workqueue.h>
 
 #include "debug.h"
 #include "pci_ids.h"
 #include "aura-gpu-reg.h"
 #include "aura-gpu-i2c.h"
+#include "aura-gpu-ddc.h"
+#include "aura-gpu-bios.h"
+#include "aura-gpu-trace.h"
+#include "aura-gpu-async.h"
+#include "aura-gpu-stats.h"
+#include "aura-gpu-backend.h"
 #include "asic/asic-registers.h"
 
 enum {
     GPU_I2C_TIMEOUT_DELAY    = 1000,
     GPU_I2C_TIMEOUT_INTERVAL = 10,
+    /* Shortest re-check after the expected completion was missed, in us */
+    GPU_I2C_POLL_BACKOFF_MIN = 10,
+    /* START, repeated START and STOP conditions, in bit times */
+    GPU_I2C_FRAMING_BITS     = 3,
+    /* Bus time model correction, 8.8 fixed point, clamped to 1/4..4 */
+    GPU_I2C_SCALE_ONE        = 256,
+    GPU_I2C_SCALE_MIN        = GPU_I2C_SCALE_ONE / 4,
+    GPU_I2C_SCALE_MAX        = GPU_I2C_SCALE_ONE * 4,
+    /* Bus speeds accepted through sysfs, in kHz */
+    GPU_I2C_SPEED_MIN        = 10,
+    GPU_I2C_SPEED_MAX        = 400,
+    GPU_I2C_DEFAULT_SPEED    = 50,
+    /* Idle time after which the engine is handed back, in ms */
+    GPU_I2C_IDLE_RELEASE     = 100,
+    /* The buffer holds 16 bytes, the first being the address */
+    GPU_I2C_MAX_TRANSFER     = 15,
+    /* Bound on clocking a stuck bus out, in us */
+    GPU_I2C_RECOVERY_WAIT    = 1000,
+    /* Longest sleep before retrying a message, in us */
+    GPU_I2C_BACKOFF_MAX      = 1000,
 };
 
+static bool use_irq = false;
+module_param(use_irq, bool, 0444);
+MODULE_PARM_DESC(use_irq, "Share the GPU's legacy interrupt line for GENERIC_I2C_DONE, only works when amdgpu is not using MSI (default: false)");
+
 enum aura_i2c_result {
     I2C_CHANNEL_OPERATION_SUCCEEDED,
     I2C_CHANNEL_OPERATION_FAILED,
@@ -43,19 +78,18 @@ enum aura_i2c_action {
     DCE_I2C_TRANSACTION_ACTION_DP_READ = 0x90
 };
 
-enum aura_i2c_status {
-    DC_I2C_STATUS__DC_I2C_STATUS_IDLE,
-    DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_SW,
-    DC_I2C_STATUS__DC_I2C_STATUS_USED_BY_HW,
-    DC_I2C_REG_RW_CNTL_STATUS_DMCU_ONLY = 2,
-};
-
 struct aura_i2c_context {
     struct aura_reg_service     *reg_service;
     enum aura_asic_type         asic_type;
+    const struct asic_context   *asic;
 
+    /* Raw GENERIC_I2C_SPEED found on open, restored on close */
     uint32_t                    original_speed;
+    /* Speed programmed on open, in kHz */
     uint32_t                    default_speed;
+    uint32_t                    current_speed;
+    /* Engine reference clock in kHz, zero leaves the speed untouched */
+    uint32_t                    reference_frequency;
 
     uint32_t                    timeout_delay;
     uint32_t                    timeout_interval;
@@ -65,7 +99,32 @@ struct aura_i2c_context {
     const struct i2c_mask       *masks;
 
     struct i2c_adapter          i2c_adapter;
-    struct mutex                mutex;
+    struct aura_i2c_queue       *queue;
+    struct aura_stats           *stats;
+
+    /* Shared with the adapters of the GPU's other lines */
+    struct aura_gpu_engine      *engine;
+    struct aura_gpu_line        line;
+
+    /* Signalled by the DONE interrupt, or by the timer standing in for it */
+    struct completion           done;
+    struct hrtimer              timer;
+    int                         irq;
+
+    /* Ratio of measured to modelled bus time, see calculate_timeout() */
+    uint32_t                    bus_scale;
+    /* Outcome of the last transaction, tells a stuck bus from a NACK */
+    enum aura_i2c_result        result;
+
+    /*
+     * The engine stays configured between transfers, see close_engine().
+     * Only the engine's owner can be configured.
+     */
+    bool                        configured;
+    bool                        faulted;
+    unsigned long               last_used;
+    unsigned int                idle_ms;
+    struct delayed_work         idle_work;
 };
 
 #define context_from_adapter(ptr) ( \
@@ -83,6 +142,8 @@ struct aura_i2c_payload {
 struct aura_i2c_transaction {
 	enum aura_i2c_action   action;
 	enum aura_i2c_result   status;
+	/* Without a START, address holds the first data byte */
+	bool                   start;
 	uint8_t                address;
 	uint32_t               length;
 	uint8_t                *data;
@@ -103,16 +164,68 @@ static void clear_ack (
     }, 1);
 }
 
-static error_t open_engine (
+static void set_speed (
+    struct aura_i2c_context *context,
+    uint32_t speed
+){
+    if (!speed || !context->reference_frequency)
+        return;
+
+    reg_update_ex(context->reg_service, context->registers->GENERIC_I2C_SPEED, (struct reg_fields[]){
+        /*
+            Bus clock is the reference clock divided by the prescaler.
+            Faster than standard mode needs the longer START/STOP
+            hold times.
+         */
+        PIN_FIELDS(context, GENERIC_I2C_PRESCALE, context->reference_frequency / speed),
+        PIN_FIELDS(context, GENERIC_I2C_THRESHOLD, 2),
+        PIN_FIELDS(context, GENERIC_I2C_START_STOP_TIMING_CNTL, speed > 50 ? 2 : 1),
+    }, 3);
+}
+
+/* Programs the requested speed, unless the engine already runs at it */
+static void apply_speed (
     struct aura_i2c_context *context
 ){
-    struct aura_reg_service *reg;
+    uint32_t speed = READ_ONCE(context->default_speed);
 
-    if (IS_NULL(context))
-        return -EINVAL;
+    if (context->reference_frequency && speed != context->current_speed) {
+        set_speed(context, speed);
+        context->current_speed = speed;
+    }
+}
+
+static void declare_shadows (
+    struct aura_i2c_context *context
+){
+    const struct i2c_registers *regs = context->registers;
+    const struct i2c_mask *masks = context->masks;
+    struct aura_reg_service *reg = context->reg_service;
+    error_t err;
+
+    /*
+        Nothing else writes these while the engine is ours, so updates
+        can skip the read back. GO and the resets self-clear, DONE_INT
+        is raised by the engine and DONE_ACK is write one to clear.
+     */
+    err = reg_cache_declare(reg, regs->GENERIC_I2C_CONTROL,
+        masks->GENERIC_I2C_GO | masks->GENERIC_I2C_SEND_RESET | masks->GENERIC_I2C_SOFT_RESET);
+    err = err ?: reg_cache_declare(reg, regs->GENERIC_I2C_TRANSACTION, 0);
+    err = err ?: reg_cache_declare(reg, regs->GENERIC_I2C_PIN_SELECTION, 0);
+    err = err ?: reg_cache_declare(reg, regs->GENERIC_I2C_INTERRUPT_CONTROL,
+        masks->GENERIC_I2C_DONE_INT | masks->GENERIC_I2C_DONE_ACK);
+
+    if (err)
+        AURA_DBG("Register shadowing unavailable: %d", err);
+}
 
-    mutex_lock(&context->mutex);
-    reg = context->reg_service;
+static void program_engine (
+    struct aura_i2c_context *context
+){
+    struct aura_reg_service *reg = context->reg_service;
+
+    /* Whoever had the engine before may have changed anything */
+    reg_cache_invalidate(reg);
 
     reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
         /*
@@ -137,34 +250,60 @@ static error_t open_engine (
             GENERIC_I2C_SCL_PIN_SEL ==
             GENERIC_I2C_SDA_PIN_SEL => disable pin selectin.
 
-            TODO: Where do these values come from and are they
-                  specific to asic types?
+            The pads of the line, as listed in the bios
+            GPIO_Pin_LUT.
          */
-        PIN_FIELDS(context, GENERIC_I2C_SCL_PIN_SEL, 0x29),
-        PIN_FIELDS(context, GENERIC_I2C_SDA_PIN_SEL, 0x28),
+        PIN_FIELDS(context, GENERIC_I2C_SCL_PIN_SEL, context->line.scl_pin),
+        PIN_FIELDS(context, GENERIC_I2C_SDA_PIN_SEL, context->line.sda_pin),
     }, 2);
 
-    // set_speed(engine, 100);
+    if (context->irq) {
+        reg_update_ex(reg, context->registers->GENERIC_I2C_INTERRUPT_CONTROL, (struct reg_fields[]){
+            /*
+                Raise an interrupt on GENERIC_I2C_DONE
+             */
+            PIN_FIELDS(context, GENERIC_I2C_DONE_ACK, 1),
+            PIN_FIELDS(context, GENERIC_I2C_DONE_MASK, 1),
+        }, 2);
+    }
 
-    return 0;
+    context->current_speed = 0;
 }
 
-static void close_engine (
+static void configure_engine (
+    struct aura_i2c_context *context
+){
+    program_engine(context);
+
+    if (context->reference_frequency)
+        context->original_speed = reg_read(context->reg_service, context->registers->GENERIC_I2C_SPEED);
+
+    context->configured = true;
+}
+
+static void release_engine (
     struct aura_i2c_context *context
 ){
     struct aura_reg_service *reg = context->reg_service;
     // struct reg_fields sw_status = PIN_FIELDS(engine, GENERIC_I2C_STATUS, 0);
 
-    // set_speed(engine, engine->original_speed);
+    if (context->reference_frequency)
+        reg_write(reg, context->registers->GENERIC_I2C_SPEED, context->original_speed);
+
+    if (context->irq) {
+        reg_update_ex(reg, context->registers->GENERIC_I2C_INTERRUPT_CONTROL, (struct reg_fields[]){
+            /*
+                Mask the interrupt again, the line is shared
+             */
+            PIN_FIELDS(context, GENERIC_I2C_DONE_MASK, 0),
+        }, 1);
+    }
 
     reg_update_ex(reg, context->registers->GENERIC_I2C_PIN_SELECTION, (struct reg_fields[]){
         /*
             GPIO pin selection to use for SCL, if
             GENERIC_I2C_SCL_PIN_SEL ==
             GENERIC_I2C_SDA_PIN_SEL => disable pin selectin.
-
-            TODO: Where do these values come from and are they
-                  specific to asic types?
          */
         PIN_FIELDS(context, GENERIC_I2C_SCL_PIN_SEL, 0),
         PIN_FIELDS(context, GENERIC_I2C_SDA_PIN_SEL, 0),
@@ -172,22 +311,202 @@ static void close_engine (
 
     reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
         /*
-            Reset the controller
+            Disable the controller, resetting it only when the
+            last transfer left it in an unknown state
          */
         PIN_FIELDS(context, GENERIC_I2C_ENABLE, 0),
-        PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, 1),
+        PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, context->faulted),
+    }, 2);
+
+    if (context->faulted) {
+        reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
+            /*
+                Clear the reset flag
+             */
+            PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, 0),
+        }, 1);
+    }
+
+    context->configured = false;
+    context->faulted = false;
+
+    if (context->engine->owner == context)
+        context->engine->owner = NULL;
+}
+
+/*
+ * Disables the engine and drops the pads between transfers, keeping the
+ * speed and saved state for the next open. Nothing of ours stays live once
+ * the arbiter grant is handed back.
+ */
+static void park_engine (
+    struct aura_i2c_context *context
+){
+    struct aura_reg_service *reg = context->reg_service;
+
+    reg_update_ex(reg, context->registers->GENERIC_I2C_PIN_SELECTION, (struct reg_fields[]){
+        PIN_FIELDS(context, GENERIC_I2C_SCL_PIN_SEL, 0),
+        PIN_FIELDS(context, GENERIC_I2C_SDA_PIN_SEL, 0),
     }, 2);
 
     reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
-        /*
-            Clear the reset flag
-         */
-        PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, 0),
+        PIN_FIELDS(context, GENERIC_I2C_ENABLE, 0),
     }, 1);
+}
+
+/*
+ * Another line's adapter left the engine configured. Its saved speed is
+ * inherited, since that is what the engine held before either used it.
+ */
+static void take_over_engine (
+    struct aura_i2c_context *context,
+    struct aura_i2c_context *previous
+){
+    context->original_speed = previous->original_speed;
+    previous->configured = false;
+
+    program_engine(context);
+    context->configured = true;
+}
+
+/*
+ * No documentation says whether DC_I2C_ARBITRATION covers this engine as
+ * well as DC_I2C. The grant is taken anyway, shared with the GPU's DC_I2C
+ * engine, so a transfer never overlaps one the display core has started.
+ * It is returned after every transfer, with the engine parked, so a
+ * configured engine is programmed again each time it is taken back.
+ */
+static error_t acquire_engine (
+    struct aura_i2c_context *context
+){
+    int ret;
+
+    ret = aura_gpu_arbiter_acquire(context->engine->arbiter, context->reg_service, context->asic, context->stats);
+    if (ret < 0)
+        return ret;
+
+    if (context->configured)
+        program_engine(context);
 
-    mutex_unlock(&context->mutex);
+    return 0;
+}
+
+static void relinquish_engine (
+    struct aura_i2c_context *context
+){
+    aura_gpu_arbiter_release(context->engine->arbiter, context->reg_service, context->asic);
 }
 
+/* Releases a configured engine outside of open_engine()/close_engine() */
+static void retire_engine (
+    struct aura_i2c_context *context
+){
+    /* Whoever holds it now owns the configuration too */
+    if (aura_gpu_arbiter_acquire(context->engine->arbiter, context->reg_service, context->asic, context->stats) < 0) {
+        context->configured = false;
+        return;
+    }
+
+    release_engine(context);
+    relinquish_engine(context);
+}
+
+/* Hands the engine back for good, the adapter is going away */
+static void detach_engine (
+    struct aura_i2c_context *context
+){
+    cancel_delayed_work_sync(&context->idle_work);
+
+    mutex_lock(&context->engine->lock);
+
+    if (context->configured)
+        retire_engine(context);
+    if (context->engine->owner == context)
+        context->engine->owner = NULL;
+
+    mutex_unlock(&context->engine->lock);
+}
+
+static error_t open_engine (
+    struct aura_i2c_context *context
+){
+    struct aura_i2c_context *previous;
+    error_t err;
+
+    if (IS_NULL(context))
+        return -EINVAL;
+
+    mutex_lock(&context->engine->lock);
+
+    err = acquire_engine(context);
+    if (err) {
+        mutex_unlock(&context->engine->lock);
+        return err;
+    }
+
+    /* Nothing stops the display core using the engine between our opens */
+    reg_cache_invalidate(context->reg_service);
+
+    previous = context->engine->owner;
+    if (previous && previous != context && previous->configured)
+        take_over_engine(context, previous);
+    else if (!context->configured)
+        configure_engine(context);
+
+    context->engine->owner = context;
+    apply_speed(context);
+
+    return 0;
+}
+
+/*
+ * Keeps the engine's speed and saved state for the next transfer, the idle
+ * work restores them once nothing has used it for idle_ms. A failed
+ * transfer, or an idle_ms of zero, releases it straight away. The arbiter
+ * grant is always returned, with the engine parked first, so neither an
+ * idle engine nor its pads are left to the display core.
+ */
+static void close_engine (
+    struct aura_i2c_context *context
+){
+    unsigned int idle_ms = READ_ONCE(context->idle_ms);
+
+    if (context->faulted || !idle_ms) {
+        release_engine(context);
+    } else {
+        park_engine(context);
+        context->last_used = jiffies;
+        mod_delayed_work(system_wq, &context->idle_work, msecs_to_jiffies(idle_ms));
+    }
+
+    relinquish_engine(context);
+    mutex_unlock(&context->engine->lock);
+}
+
+static void idle_engine_work (
+    struct work_struct *work
+){
+    struct aura_i2c_context *context = container_of(to_delayed_work(work), struct aura_i2c_context, idle_work);
+    unsigned long expires;
+
+    mutex_lock(&context->engine->lock);
+
+    /* Raced with a transfer, which has re-armed the work */
+    expires = context->last_used + msecs_to_jiffies(READ_ONCE(context->idle_ms));
+    if (context->configured && !time_before(jiffies, expires))
+        retire_engine(context);
+
+    mutex_unlock(&context->engine->lock);
+}
+
+
+/* A GENERIC_I2C_DATA value carrying a single buffer byte */
+static inline uint32_t data_word (
+    const struct aura_i2c_context *context,
+    uint8_t byte
+){
+    return ((uint32_t)byte << context->shifts->GENERIC_I2C_DATA) & context->masks->GENERIC_I2C_DATA;
+}
 
 static bool process_transaction (
     const struct aura_i2c_context *context,
@@ -196,7 +515,15 @@ static bool process_transaction (
     struct aura_reg_service *reg = context->reg_service;
     uint32_t length = request->length;
     uint8_t *buffer = request->data;
-    uint32_t value = 0;
+    uint32_t words[GPU_I2C_MAX_TRANSFER + 1];
+    uint32_t count = 1;
+    /* Without a STOP the bus stays held and the next message begins with a repeated START */
+    bool mot = request->action == DCE_I2C_TRANSACTION_ACTION_I2C_WRITE_MOT ||
+               request->action == DCE_I2C_TRANSACTION_ACTION_I2C_READ_MOT;
+
+    /* COUNT and INDEX are 4 bit fields */
+    if (length > GPU_I2C_MAX_TRANSFER)
+        return false;
 
     /*
         Configure the transaction register
@@ -237,7 +564,7 @@ static bool process_transaction (
              1=START
             MASK == 0x1000
          */
-        PIN_FIELDS(context, GENERIC_I2C_START, 1),
+        PIN_FIELDS(context, GENERIC_I2C_START, request->start),
         /*
             Determines whether a stop bit will be sent after the second
             transaction
@@ -245,7 +572,7 @@ static bool process_transaction (
              1=STOP
             MASK == 0x2000
          */
-        PIN_FIELDS(context, GENERIC_I2C_STOP, true ? 1 : 0),
+        PIN_FIELDS(context, GENERIC_I2C_STOP, !mot),
         /*
             Byte count for the transaction (excluding the first byte,
             which is usually the address).
@@ -262,51 +589,22 @@ static bool process_transaction (
      * for I2C receive operation, the LSB must be programmed to 1.
      *
      */
-    value = reg_set_ex(reg, context->registers->GENERIC_I2C_DATA, 0, (struct reg_fields[]){
-        /*
-            Select whether buffer access will be a read or write. For
-            writes, address auto-increments on write to DC_I2C_DATA.
-            For reads, address auto-increments on reads to
-            GENERIC_I2C_DATA.
-             0=Write
-             1=Read
-            MASK == 0x1
-         */
-        PIN_FIELDS(context, GENERIC_I2C_DATA_RW, false),
-        /*
-            Use to fill or read the generic I2C buffer
-            MASK == 0xff00
-         */
-        PIN_FIELDS(context, GENERIC_I2C_DATA, request->address),
-        /*
-            Use to set index into I2C buffer for next read or current
-            write, or to read index of current read or next write. Writable
-            only when GENERIC_I2C_INDEX_WRITE=1.
-            MASK == 0xf0000
-         */
-        PIN_FIELDS(context, GENERIC_I2C_INDEX, 0),
-        /*
-            To write index field, set this bit to 1 while writing
-            GENERIC_I2C_DATA
-            MASK == 0x80000000
-         */
-        PIN_FIELDS(context, GENERIC_I2C_INDEX_WRITE, 1),
-    }, 4);
+    /*
+        The first entry selects buffer writes (GENERIC_I2C_DATA_RW = 0)
+        and rewinds the buffer to index 0, GENERIC_I2C_INDEX is only
+        writable while GENERIC_I2C_INDEX_WRITE is set. The index then
+        auto-increments on each write to GENERIC_I2C_DATA.
+     */
+    words[0] = data_word(context, request->address) | context->masks->GENERIC_I2C_INDEX_WRITE;
 
     if (!(request->action & DCE_I2C_TRANSACTION_ACTION_I2C_READ)) {
-        // TODO this should auto increment
-        uint8_t index = 1;
-        while (length) {
-            reg_set_ex(reg, context->registers->GENERIC_I2C_DATA, 0, (struct reg_fields[]){
-                PIN_FIELDS(context, GENERIC_I2C_INDEX, index),
-                PIN_FIELDS(context, GENERIC_I2C_DATA, *buffer++),
-            }, 2);
-
-            ++index;
-            --length;
-        }
+        /* Following bytes leave the index alone and rely on the auto increment */
+        while (length--)
+            words[count++] = data_word(context, *buffer++);
     }
 
+    reg_write_seq(reg, context->registers->GENERIC_I2C_DATA, words, count);
+
     return true;
 }
 
@@ -328,13 +626,10 @@ static void process_reply (
     struct aura_i2c_payload *reply
 ){
     struct aura_reg_service *reg = context->reg_service;
-    uint32_t length = reply->length;
+    uint32_t length = min_t(uint32_t, reply->length, GPU_I2C_MAX_TRANSFER);
     uint8_t *buffer = reply->data;
-    uint8_t index = 1;
-    struct reg_fields data[] = {
-        PIN_FIELDS(context, GENERIC_I2C_INDEX, 1),
-        PIN_FIELDS(context, GENERIC_I2C_DATA, 0)
-    };
+    uint32_t words[GPU_I2C_MAX_TRANSFER];
+    uint32_t i;
 
     // AURA_DBG("process_reply");
 
@@ -369,17 +664,14 @@ static void process_reply (
         NOTE: Some controllers, this IR3567B in particular, will repeat the
         first byte when trying to read multiple.
      */
-    while (length) {
-        data[0].value = ++index;
-        /*
-            The register buffer auto increments. To get its current index
-            use DC_I2C_INDEX above
-         */
-        reg_get_ex(reg, context->registers->GENERIC_I2C_DATA, data, 2);
-        *buffer++ = data[1].value;
+    /*
+        The register buffer auto increments on every read, so the bytes
+        are drained back to back from the index set above.
+     */
+    reg_read_seq(reg, context->registers->GENERIC_I2C_DATA, words, length);
 
-        --length;
-    }
+    for (i = 0; i < length; i++)
+        buffer[i] = (words[i] & context->masks->GENERIC_I2C_DATA) >> context->shifts->GENERIC_I2C_DATA;
 
     // AURA_DBG("Reading %d bytes: 0x%02x", reply->length, reply->data[0]);
 
@@ -426,23 +718,234 @@ static enum aura_i2c_result get_channel_status (
     return I2C_CHANNEL_OPERATION_SUCCEEDED;
 }
 
+/*
+ * Models the time the bus needs for @length bytes, each being 8 data bits
+ * and an ACK, plus the START and STOP conditions. Clock stretching and the
+ * engine's own latency are folded into the per-adapter bus_scale.
+ *
+ * @return: Expected duration in microseconds
+ */
+static uint32_t calculate_timeout (
+    const struct aura_i2c_context *context,
+    uint32_t length
+){
+    uint32_t bits = length * 9 + GPU_I2C_FRAMING_BITS;
+    uint32_t speed = context->current_speed ? context->current_speed : GPU_I2C_DEFAULT_SPEED;
+    uint64_t us = DIV_ROUND_UP(bits * 1000, speed);
+
+    return (uint32_t)((us * context->bus_scale) / GPU_I2C_SCALE_ONE);
+}
+
+/* Folds a measured completion into the model, with a weight of 1/8 */
+static void update_timeout (
+    struct aura_i2c_context *context,
+    uint32_t expected,
+    s64 measured
+){
+    int64_t scale;
+
+    if (!expected || measured <= 0)
+        return;
+
+    scale = div64_s64(measured * context->bus_scale, expected);
+    scale = context->bus_scale + ((scale - (int64_t)context->bus_scale) / 8);
+
+    context->bus_scale = clamp_t(int64_t, scale, GPU_I2C_SCALE_MIN, GPU_I2C_SCALE_MAX);
+}
+
+/*
+ * Sleeps until the engine leaves the busy state. Each wake up comes from
+ * either the DONE interrupt or the hrtimer, which is armed in both modes so
+ * a missed interrupt only costs one timer period.
+ *
+ * Without an interrupt, the first check lands slightly before the expected
+ * completion so the model can learn when the bus is faster than predicted,
+ * then backs off exponentially up to timeout_delay.
+ */
 enum aura_i2c_result poll_engine (
-    struct aura_i2c_context *context
+    struct aura_i2c_context *context,
+    uint32_t expected
 ){
     enum aura_i2c_result result;
-    uint32_t timeout = context->timeout_interval;
+    ktime_t start = ktime_get();
+    ktime_t deadline = ktime_add_us(start, (u64)context->timeout_delay * context->timeout_interval);
+    uint32_t backoff = max_t(uint32_t, expected / 8, GPU_I2C_POLL_BACKOFF_MIN);
+    uint32_t period;
+
+    if (context->irq)
+        period = context->timeout_delay;
+    else
+        period = max_t(uint32_t, expected - expected / 8, GPU_I2C_POLL_BACKOFF_MIN);
+
+    for (;;) {
+        hrtimer_start(&context->timer, us_to_ktime(period), HRTIMER_MODE_REL);
+        wait_for_completion(&context->done);
+        hrtimer_cancel(&context->timer);
+        reinit_completion(&context->done);
 
-    do {
         result = get_channel_status(context);
         if (result != I2C_CHANNEL_OPERATION_ENGINE_BUSY)
             break;
 
-        udelay(context->timeout_delay);
-    } while (timeout--);
+        if (ktime_after(ktime_get(), deadline)) {
+            result = I2C_CHANNEL_OPERATION_TIMEOUT;
+            break;
+        }
+
+        if (!context->irq) {
+            period = min_t(uint32_t, backoff, context->timeout_delay);
+            backoff *= 2;
+        }
+    }
+
+    if (result == I2C_CHANNEL_OPERATION_SUCCEEDED)
+        update_timeout(context, expected, ktime_us_delta(ktime_get(), start));
+
+    clear_ack(context);
+    aura_stats_time(context->stats, AURA_HIST_POLL, start);
+
+    return result;
+}
+
+static enum hrtimer_restart poll_engine_timer (
+    struct hrtimer *timer
+){
+    struct aura_i2c_context *context = container_of(timer, struct aura_i2c_context, timer);
+
+    complete(&context->done);
+
+    return HRTIMER_NORESTART;
+}
+
+static irqreturn_t aura_gpu_i2c_irq (
+    int irq,
+    void *data
+){
+    struct aura_i2c_context *context = data;
+    struct reg_fields done = PIN_FIELDS(context, GENERIC_I2C_DONE_INT, 0);
+
+    /* Every line's adapter shares the irq, only the owner acknowledges */
+    if (READ_ONCE(context->engine->owner) != context)
+        return IRQ_NONE;
+
+    reg_get_ex(context->reg_service, context->registers->GENERIC_I2C_INTERRUPT_CONTROL, &done, 1);
+    if (!done.value)
+        return IRQ_NONE;
+
+    clear_ack(context);
+    complete(&context->done);
+
+    return IRQ_HANDLED;
+}
+
+static void account_result (
+    struct aura_i2c_context *context,
+    enum aura_i2c_result result
+){
+    switch (result) {
+    case I2C_CHANNEL_OPERATION_TIMEOUT:
+        aura_stats_inc(context->stats, AURA_STAT_TIMEOUT);
+        break;
+    case I2C_CHANNEL_OPERATION_NO_RESPONSE:
+        aura_stats_inc(context->stats, AURA_STAT_NO_RESPONSE);
+        break;
+    case I2C_CHANNEL_OPERATION_ENGINE_BUSY:
+        aura_stats_inc(context->stats, AURA_STAT_ENGINE_BUSY);
+        break;
+    case I2C_CHANNEL_OPERATION_FAILED:
+        aura_stats_inc(context->stats, AURA_STAT_ABORTED);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Idle, with no abort or timeout latched */
+static bool engine_idle (
+    struct aura_i2c_context *context
+){
+    struct reg_fields status = PIN_FIELDS(context, GENERIC_I2C_STATUS, 0);
+    uint32_t value = reg_get_ex(context->reg_service, context->registers->GENERIC_I2C_STATUS, &status, 1);
+
+    return !status.value && !(value & (context->masks->GENERIC_I2C_ABORTED | context->masks->GENERIC_I2C_TIMEOUT));
+}
+
+/*
+ * An abort or timeout reported by the engine usually means a slave is
+ * holding SDA low. A request refused before GO never reached the bus.
+ */
+static inline bool bus_stuck (
+    enum aura_i2c_result result
+){
+    return result == I2C_CHANNEL_OPERATION_TIMEOUT || result == I2C_CHANNEL_OPERATION_FAILED;
+}
+
+/*
+ * Brings a stuck bus back without waiting for the engine to be released.
+ * The engine is reset and reprogrammed, then GENERIC_I2C_SEND_RESET clocks
+ * the bus until the slave lets go of SDA, and the engine must come back
+ * idle. The engine must be open.
+ *
+ * @return: Zero when the bus is idle again
+ */
+static error_t recover_bus (
+    struct aura_i2c_context *context
+){
+    struct aura_reg_service *reg = context->reg_service;
+    ktime_t start = ktime_get();
+    ktime_t deadline = ktime_add_us(start, GPU_I2C_RECOVERY_WAIT);
+    bool idle;
+
+    aura_stats_inc(context->stats, AURA_STAT_BUS_RECOVERIES);
+
+    reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Drop whatever the aborted transaction left behind
+         */
+        PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, 1),
+    }, 1);
+
+    reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Clear the reset flag
+         */
+        PIN_FIELDS(context, GENERIC_I2C_SOFT_RESET, 0),
+    }, 1);
+
+    /* The reset may have taken the configuration with it */
+    program_engine(context);
+    apply_speed(context);
+
+    reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Write 1 to clock the bus out, 9 clocks followed by a
+            STOP
+         */
+        PIN_FIELDS(context, GENERIC_I2C_SEND_RESET, 1),
+    }, 1);
+
+    do {
+        usleep_range(GPU_I2C_POLL_BACKOFF_MIN, GPU_I2C_POLL_BACKOFF_MIN * 2);
+        idle = engine_idle(context);
+    } while (!idle && ktime_before(ktime_get(), deadline));
+
+    reg_update_ex(reg, context->registers->GENERIC_I2C_CONTROL, (struct reg_fields[]){
+        /*
+            Clear the reset flag
+         */
+        PIN_FIELDS(context, GENERIC_I2C_SEND_RESET, 0),
+    }, 1);
 
     clear_ack(context);
+    aura_stats_time(context->stats, AURA_HIST_RECOVERY, start);
+
+    if (!idle || !engine_idle(context)) {
+        AURA_DBG("Bus still busy after a reset");
+        aura_stats_inc(context->stats, AURA_STAT_RECOVERY_FAILURES);
+        return -EIO;
+    }
 
-    return timeout != 0 ? result : I2C_CHANNEL_OPERATION_TIMEOUT;
+    return 0;
 }
 
 
@@ -454,20 +957,22 @@ static void submit_transaction (
 
     if (!process_transaction(context, request)) {
         AURA_DBG("Failed to process transaction");
+        request->status = I2C_CHANNEL_OPERATION_WRONG_PARAMETER;
         return;
     }
 
     execute_transaction(context);
 }
 
-static bool submit_payload (
+static bool submit_chunk (
     struct aura_i2c_context *context,
     struct aura_i2c_payload *payload,
+    bool start,
     bool middle_of_transaction
 ){
     struct aura_i2c_transaction request;
     enum aura_i2c_result operation_result;
-    // uint32_t transaction_timeout;
+    uint32_t transaction_timeout;
 
     if (!payload->write) {
         request.action = middle_of_transaction ?
@@ -479,20 +984,35 @@ static bool submit_payload (
             DCE_I2C_TRANSACTION_ACTION_I2C_WRITE;
     }
 
-    request.address = (uint8_t) ((payload->address << 1) | !payload->write);
-    request.length  = payload->length;
-    request.data    = payload->data;
+    request.start = start;
+    if (start) {
+        request.address = (uint8_t) ((payload->address << 1) | !payload->write);
+        request.length  = payload->length;
+        request.data    = payload->data;
+    } else {
+        /* A write continuation, the buffer starts with data */
+        request.address = payload->data[0];
+        request.length  = payload->length - 1;
+        request.data    = payload->data + 1;
+    }
 
     /* obtain timeout value before submitting request */
-    // transaction_timeout = calculate_timeout(engine, payload->length + 1);
+    transaction_timeout = calculate_timeout(context, request.length + 1);
 
+    reinit_completion(&context->done);
     submit_transaction(context, &request);
 
-    if ((request.status == I2C_CHANNEL_OPERATION_FAILED) || (request.status == I2C_CHANNEL_OPERATION_ENGINE_BUSY))
+    /* Never started, the bus has not seen the transaction */
+    if (request.status != I2C_CHANNEL_OPERATION_SUCCEEDED) {
+        context->result = request.status;
+        account_result(context, request.status);
         return false;
+    }
 
     /* wait until transaction proceed */
-    operation_result = poll_engine(context);
+    operation_result = poll_engine(context, transaction_timeout);
+    context->result = operation_result;
+    account_result(context, operation_result);
 
     /* update transaction status */
     if (operation_result == I2C_CHANNEL_OPERATION_SUCCEEDED) {
@@ -505,75 +1025,512 @@ static bool submit_payload (
     return false;
 }
 
+/*
+ * Splits a write into runs which fit the engine's 16 entry buffer, each run
+ * being started as soon as the previous one completes. Continuation runs
+ * have no START, so the first buffer entry carries data instead of the
+ * address. A read cannot be continued without being addressed again, which
+ * is not the same transfer to the device, so reads must fit a single run.
+ *
+ * @nostart: The payload continues the previous write, I2C_M_NOSTART
+ * @sent: Bytes of the payload in runs which completed
+ */
+static bool submit_payload (
+    struct aura_i2c_context *context,
+    struct aura_i2c_payload *payload,
+    bool middle_of_transaction,
+    bool nostart,
+    uint32_t *sent
+){
+    struct aura_i2c_payload chunk = *payload;
+    uint32_t offset = 0;
+    uint32_t remaining;
+    bool start, last;
 
-static int aura_gpu_i2c_xfer (
-    struct i2c_adapter *i2c_adapter,
-    struct i2c_msg *msgs,
+    do {
+        remaining = payload->length - offset;
+        start = !(payload->write && (offset || nostart));
+
+        chunk.data   = payload->data + offset;
+        chunk.length = min_t(uint32_t, remaining, start ? GPU_I2C_MAX_TRANSFER : GPU_I2C_MAX_TRANSFER + 1);
+
+        *sent = offset;
+        offset += chunk.length;
+        last = (offset == payload->length);
+
+        if (!submit_chunk(context, &chunk, start, last ? middle_of_transaction : true))
+            return false;
+    } while (!last);
+
+    return true;
+}
+
+/*
+ * I2C_M_NOSTART is only honoured on writes continuing a write to the same
+ * address, those are sent as continuation runs without a START. Reads are
+ * limited to one run, the core checks the same through the adapter quirks
+ * but queued transfers do not pass through it.
+ */
+static error_t check_messages (
+    const struct i2c_msg *msgs,
     int num
 ){
-    struct aura_i2c_context *context = i2c_get_adapdata(i2c_adapter);
-    struct aura_i2c_payload payload;
-    bool mot, result = true;
     int i;
 
-    if (IS_NULL(context))
+    for (i = 0; i < num; i++) {
+        if ((msgs[i].flags & I2C_M_RD) && msgs[i].len > GPU_I2C_MAX_TRANSFER)
+            return -EOPNOTSUPP;
+    }
+
+    for (i = 1; i < num; i++) {
+        if (!(msgs[i].flags & I2C_M_NOSTART))
+            continue;
+
+        if ((msgs[i].flags & I2C_M_RD) || (msgs[i - 1].flags & I2C_M_RD) || msgs[i].addr != msgs[i - 1].addr)
+            return -EOPNOTSUPP;
+
+        /* Nothing to continue with */
+        if (!msgs[i].len)
+            return -EINVAL;
+    }
+
+    return 0;
+}
+
+/*
+ * Retries allowed per transfer for each failing result, and the first
+ * backoff in us, doubled on every further attempt. A stuck bus is never
+ * retried, see abort_messages().
+ */
+static const struct {
+    uint8_t     limit;
+    uint16_t    backoff;
+} retry_policy[] = {
+    [I2C_CHANNEL_OPERATION_NO_RESPONSE] = { .limit = 3, .backoff = 100 },
+    [I2C_CHANNEL_OPERATION_ENGINE_BUSY] = { .limit = 2, .backoff = 50 },
+};
+
+/* Error handed back once a failing result ran out of retries */
+static error_t result_to_error (
+    enum aura_i2c_result result
+){
+    switch (result) {
+    case I2C_CHANNEL_OPERATION_NO_RESPONSE:
+        return -ENXIO;
+    case I2C_CHANNEL_OPERATION_ENGINE_BUSY:
+        return -EBUSY;
+    case I2C_CHANNEL_OPERATION_TIMEOUT:
+        return -ETIMEDOUT;
+    case I2C_CHANNEL_OPERATION_WRONG_PARAMETER:
+        return -EINVAL;
+    default:
         return -EIO;
+    }
+}
 
-    open_engine(context);
-
-    // for (i = 0; i < num; i++) {
-    //     if (msgs[i].flags & I2C_M_RD) {
-    //         AURA_DBG("Raw message: rw = 'r', addr = %x, flags = %x, len = %d",
-    //                     msgs[i].addr,
-    //                     msgs[i].flags,
-    //                     msgs[i].len
-    //         );
-    //     } else {
-    //         AURA_DBG("Raw message: rw = 'w', addr = %x, flags = %x, len = %d, data = %x",
-    //                     msgs[i].addr,
-    //                     msgs[i].flags,
-    //                     msgs[i].len,
-    //                     msgs[i].buf[0]
-    //         );
-    //     }
-    // }
-
-    /* Detect bus probe */
-    // if (num == 1 && msgs[0].len == 0) {
-    //     payload.
-    // }
+/*
+ * Decides whether the message which just failed gets another attempt, and
+ * backs off before it.
+ *
+ * @attempts: Retries made so far in the transfer, per result
+ */
+static bool should_retry (
+    struct aura_i2c_context *context,
+    const struct i2c_msg *msg,
+    uint8_t *attempts
+){
+    enum aura_i2c_result result = context->result;
+    unsigned int backoff;
 
-    for (i = 0; i < num; i++) {
+    if (result >= ARRAY_SIZE(retry_policy) || !retry_policy[result].limit)
+        return false;
+
+    /* A probe is answered by the NACK itself */
+    if (result == I2C_CHANNEL_OPERATION_NO_RESPONSE && !msg->len)
+        return false;
+
+    if (attempts[result] >= retry_policy[result].limit) {
+        aura_stats_inc(context->stats, AURA_STAT_RETRIES_EXHAUSTED);
+        return false;
+    }
+
+    backoff = min_t(unsigned int, retry_policy[result].backoff << attempts[result], GPU_I2C_BACKOFF_MAX);
+    if (backoff)
+        usleep_range(backoff, backoff * 2);
+
+    attempts[result]++;
+    aura_stats_inc(context->stats, AURA_STAT_RETRIES);
+
+    return true;
+}
+
+/*
+ * Ends a failed transfer. A stuck bus is cleared straight away so the next
+ * transfer finds it idle, but nothing is sent again, since the devices have
+ * acted on every byte they acknowledged before it got stuck.
+ *
+ * @return: -EAGAIN when the bus was recovered, otherwise the failure
+ */
+static error_t abort_messages (
+    struct aura_i2c_context *context
+){
+    if (bus_stuck(context->result) && !recover_bus(context))
+        return -EAGAIN;
+
+    /* Reset on release, the bus may be stuck for good */
+    context->faulted = true;
+
+    return result_to_error(context->result);
+}
+
+/*
+ * The engine has a single transaction slot and one buffer, so every message
+ * needs its own run. All but the last run leave the bus held, which turns
+ * the usual write-index-then-read into a repeated START.
+ *
+ * Only a failure in the first run of the first message is retried. Once a
+ * run has been acknowledged the devices have acted on it, and the STOP sent
+ * on a NACK has ended the combined transaction, so resending just the
+ * failing message could read from a moved register pointer or write the
+ * earlier runs twice. Such failures are handed back to the caller.
+ *
+ * The engine must already be open.
+ */
+static int __submit_messages (
+    struct aura_i2c_context *context,
+    struct i2c_msg *msgs,
+    int num
+){
+    uint8_t attempts[ARRAY_SIZE(retry_policy)] = { 0 };
+    struct aura_i2c_payload payload;
+    bool mot, nostart;
+    uint32_t sent;
+    error_t err;
+    int i = 0;
+
+    err = check_messages(msgs, num);
+    if (err)
+        return err;
+
+    while (i < num) {
         mot = (i != num - 1);
+        nostart = i && (msgs[i].flags & I2C_M_NOSTART);
         payload.write   = !(msgs[i].flags & I2C_M_RD);
         payload.address = msgs[i].addr;
         payload.length  = msgs[i].len;
         payload.data    = msgs[i].buf;
 
-        if (!submit_payload(context, &payload, mot)) {
-            result = false;
-            break;
+        if (submit_payload(context, &payload, mot, nostart, &sent)) {
+            i++;
+            continue;
         }
+
+        if (i || sent || !should_retry(context, &msgs[i], attempts))
+            return abort_messages(context);
     }
 
+    return num;
+}
+
+static int submit_messages (
+    struct aura_i2c_context *context,
+    struct i2c_msg *msgs,
+    int num
+){
+    error_t err;
+    int ret;
+
+    err = open_engine(context);
+    if (err)
+        return err;
+
+    ret = __submit_messages(context, msgs, num);
+
     close_engine(context);
 
-    return result ? num : -EIO;
+    return ret;
+}
+
+static int aura_gpu_i2c_xfer (
+    struct i2c_adapter *i2c_adapter,
+    struct i2c_msg *msgs,
+    int num
+){
+    struct aura_i2c_context *context = i2c_get_adapdata(i2c_adapter);
+    ktime_t start = ktime_get();
+    int ret;
+
+    if (IS_NULL(context))
+        return -EIO;
+
+    trace_aura_i2c_xfer_start(i2c_adapter, msgs, num);
+    ret = submit_messages(context, msgs, num);
+    trace_aura_i2c_xfer_end(i2c_adapter, num, ret);
+
+    if (num > 0)
+        aura_stats_xfer(context->stats, msgs[0].addr, num, aura_stats_msg_bytes(msgs, num), ret, start);
+
+    return ret;
+}
+
+/*
+ * SMBus commands are built straight into one or two engine transactions,
+ * the first always a write of the command byte.
+ */
+static int aura_gpu_i2c_smbus_xfer (
+    struct i2c_adapter *i2c_adapter,
+    uint16_t addr,
+    unsigned short flags,
+    char read_write,
+    uint8_t command,
+    int size,
+    union i2c_smbus_data *data
+){
+    struct aura_i2c_context *context = i2c_get_adapdata(i2c_adapter);
+    bool read = (read_write == I2C_SMBUS_READ);
+    uint8_t buffer[I2C_SMBUS_BLOCK_MAX + 1];
+    struct i2c_msg msgs[2] = {
+        { .addr = addr, .flags = 0,        .len = 1, .buf = buffer },
+        { .addr = addr, .flags = I2C_M_RD, .len = 0, .buf = buffer + 1 },
+    };
+    int num = read ? 2 : 1;
+    ktime_t start = ktime_get();
+    int ret;
+
+    if (IS_NULL(context))
+        return -EIO;
+
+    if (flags & I2C_CLIENT_PEC)
+        return -EOPNOTSUPP;
+
+    buffer[0] = command;
+
+    switch (size) {
+    case I2C_SMBUS_QUICK:
+        msgs[0].flags = read ? I2C_M_RD : 0;
+        msgs[0].len = 0;
+        num = 1;
+        break;
+    case I2C_SMBUS_BYTE:
+        msgs[0].flags = read ? I2C_M_RD : 0;
+        num = 1;
+        break;
+    case I2C_SMBUS_BYTE_DATA:
+        if (read) {
+            msgs[1].len = 1;
+        } else {
+            buffer[1] = data->byte;
+            msgs[0].len = 2;
+        }
+        break;
+    case I2C_SMBUS_WORD_DATA:
+        if (read) {
+            msgs[1].len = 2;
+        } else {
+            buffer[1] = data->word & 0xff;
+            buffer[2] = data->word >> 8;
+            msgs[0].len = 3;
+        }
+        break;
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        if (data->block[0] == 0 || data->block[0] > I2C_SMBUS_BLOCK_MAX)
+            return -EINVAL;
+
+        if (read) {
+            /* A short read, the caller is handed back the length */
+            data->block[0] = min_t(uint8_t, data->block[0], GPU_I2C_MAX_TRANSFER);
+            msgs[1].len = data->block[0];
+        } else {
+            memcpy(&buffer[1], &data->block[1], data->block[0]);
+            msgs[0].len = data->block[0] + 1;
+        }
+        break;
+    default:
+        return -EOPNOTSUPP;
+    }
+
+    ret = submit_messages(context, msgs, num);
+    aura_stats_xfer(context->stats, addr, 0, aura_stats_smbus_bytes(size, data), ret, start);
+    if (ret < 0)
+        return ret;
+
+    if (!read)
+        return 0;
+
+    switch (size) {
+    case I2C_SMBUS_BYTE:
+        data->byte = buffer[0];
+        break;
+    case I2C_SMBUS_BYTE_DATA:
+        data->byte = buffer[1];
+        break;
+    case I2C_SMBUS_WORD_DATA:
+        data->word = buffer[1] | (buffer[2] << 8);
+        break;
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        memcpy(&data->block[1], &buffer[1], data->block[0]);
+        break;
+    }
+
+    return 0;
 }
 
 static u32 aura_gpu_i2c_func (
     struct i2c_adapter *adap
 ){
-    return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+    /* Counted block reads need the length before the transaction starts */
+    return I2C_FUNC_I2C |
+           I2C_FUNC_NOSTART |
+           I2C_FUNC_SMBUS_QUICK |
+           I2C_FUNC_SMBUS_BYTE |
+           I2C_FUNC_SMBUS_BYTE_DATA |
+           I2C_FUNC_SMBUS_WORD_DATA |
+           I2C_FUNC_SMBUS_I2C_BLOCK;
 }
 
 static const struct i2c_algorithm aura_gpu_i2c_algo = {
     .master_xfer   = aura_gpu_i2c_xfer,
+    .smbus_xfer    = aura_gpu_i2c_smbus_xfer,
     .functionality = aura_gpu_i2c_func,
 };
 
+/* Writes are split across runs, a read has to fit the buffer */
+static const struct i2c_adapter_quirks aura_gpu_i2c_quirks = {
+    .max_read_len  = GPU_I2C_MAX_TRANSFER,
+};
+
+
+static error_t aura_gpu_i2c_queue_begin (
+    struct i2c_adapter *i2c_adapter
+){
+    return open_engine(i2c_get_adapdata(i2c_adapter));
+}
+
+static int aura_gpu_i2c_queue_xfer (
+    struct i2c_adapter *i2c_adapter,
+    struct i2c_msg *msgs,
+    int num
+){
+    struct aura_i2c_context *context = i2c_get_adapdata(i2c_adapter);
+    ktime_t start = ktime_get();
+    int ret;
+
+    trace_aura_i2c_xfer_start(i2c_adapter, msgs, num);
+    ret = __submit_messages(context, msgs, num);
+    trace_aura_i2c_xfer_end(i2c_adapter, num, ret);
+
+    if (num > 0)
+        aura_stats_xfer(context->stats, msgs[0].addr, num, aura_stats_msg_bytes(msgs, num), ret, start);
+
+    return ret;
+}
+
+static void aura_gpu_i2c_queue_end (
+    struct i2c_adapter *i2c_adapter
+){
+    close_engine(i2c_get_adapdata(i2c_adapter));
+}
+
+/* Queued requests are drained under a single open_engine/close_engine */
+static const struct aura_i2c_queue_ops aura_gpu_i2c_queue_ops = {
+    .begin = aura_gpu_i2c_queue_begin,
+    .xfer  = aura_gpu_i2c_queue_xfer,
+    .end   = aura_gpu_i2c_queue_end,
+};
+
+
+static ssize_t speed_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
+){
+    struct aura_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+
+    return sprintf(buf, "%u\n", READ_ONCE(context->default_speed));
+}
 
-static const struct asic_context* aura_gpu_i2c_get_ddc_context (
+/* Bus speed in kHz, takes effect on the next transfer */
+static ssize_t speed_store (
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count
+){
+    struct aura_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+    unsigned int speed;
+    error_t err;
+
+    err = kstrtouint(buf, 0, &speed);
+    if (err)
+        return err;
+
+    if (speed < GPU_I2C_SPEED_MIN || speed > GPU_I2C_SPEED_MAX)
+        return -EINVAL;
+
+    if (!context->reference_frequency)
+        return -EOPNOTSUPP;
+
+    WRITE_ONCE(context->default_speed, speed);
+
+    return count;
+}
+static DEVICE_ATTR_RW(speed);
+
+static ssize_t idle_ms_show (
+    struct device *dev,
+    struct device_attribute *attr,
+    char *buf
+){
+    struct aura_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+
+    return sprintf(buf, "%u\n", READ_ONCE(context->idle_ms));
+}
+
+/* Time the engine stays configured after a transfer, 0 releases it every time */
+static ssize_t idle_ms_store (
+    struct device *dev,
+    struct device_attribute *attr,
+    const char *buf,
+    size_t count
+){
+    struct aura_i2c_context *context = context_from_adapter(to_i2c_adapter(dev));
+    unsigned int idle_ms;
+    error_t err;
+
+    err = kstrtouint(buf, 0, &idle_ms);
+    if (err)
+        return err;
+
+    WRITE_ONCE(context->idle_ms, idle_ms);
+    mod_delayed_work(system_wq, &context->idle_work, msecs_to_jiffies(idle_ms));
+
+    return count;
+}
+static DEVICE_ATTR_RW(idle_ms);
+
+static struct attribute *aura_gpu_i2c_attrs[] = {
+    &dev_attr_speed.attr,
+    &dev_attr_idle_ms.attr,
+    NULL
+};
+ATTRIBUTE_GROUPS(aura_gpu_i2c);
+
+/*
+ * The engine runs from the crystal divided by two, as in the display
+ * driver. Without a usable crystal the bios programmed speed is kept.
+ */
+uint32_t aura_gpu_i2c_get_reference (
+    struct atom_bios *bios
+){
+    uint32_t frequency = 0;
+
+    if (!bios || atom_bios_get_crystal_frequency(bios, &frequency))
+        return 0;
+
+    return frequency / 2;
+}
+
+const struct asic_context* aura_gpu_i2c_get_ddc_context (
     enum aura_asic_type asic_type
 ){
     switch (asic_type) {
@@ -605,9 +1562,10 @@ static const struct asic_context* aura_gpu_i2c_get_ddc_context (
 
 static struct aura_i2c_context* aura_gpu_i2c_context_create (
     struct pci_dev *pci_dev,
-    enum aura_asic_type asic_type
+    enum aura_asic_type asic_type,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
 ){
-    struct aura_reg_service *registry;
     struct aura_i2c_context *context;
     const struct asic_context *ddc_context;
     error_t err;
@@ -620,41 +1578,75 @@ static struct aura_i2c_context* aura_gpu_i2c_context_create (
     if (!context)
         return ERR_PTR(-ENOMEM);
 
-    registry = aura_gpu_reg_create(pci_dev);
-    if (IS_ERR(registry)) {
-        err = PTR_ERR(registry);
+    context->stats = aura_stats_create();
+    if (IS_ERR(context->stats)) {
+        err = PTR_ERR(context->stats);
         goto error_free_context;
     }
 
-    mutex_init(&context->mutex);
+    context->engine             = engine;
+    context->line               = *line;
+    init_completion(&context->done);
+    hrtimer_init(&context->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    context->timer.function     = poll_engine_timer;
     context->asic_type          = asic_type;
-    context->reg_service        = registry;
+    context->reg_service        = engine->resources->reg_service;
 
+    context->asic               = ddc_context;
     context->registers          = ddc_context->i2c_registers;
     context->masks              = ddc_context->i2c_masks;
     context->shifts             = ddc_context->i2c_shifts;
+    declare_shadows(context);
 
-    context->original_speed     = 50;
-    context->default_speed      = 50;
+    context->default_speed      = GPU_I2C_DEFAULT_SPEED;
+    context->reference_frequency = engine->resources->reference_frequency;
     context->timeout_delay      = GPU_I2C_TIMEOUT_DELAY;
     context->timeout_interval   = GPU_I2C_TIMEOUT_INTERVAL;
+    context->bus_scale          = GPU_I2C_SCALE_ONE;
+    context->idle_ms            = GPU_I2C_IDLE_RELEASE;
+    INIT_DELAYED_WORK(&context->idle_work, idle_engine_work);
 
     context->i2c_adapter.owner  = THIS_MODULE;
     context->i2c_adapter.class  = I2C_CLASS_DDC;
     context->i2c_adapter.algo   = &aura_gpu_i2c_algo;
+    context->i2c_adapter.quirks = &aura_gpu_i2c_quirks;
+    context->i2c_adapter.dev.groups = aura_gpu_i2c_groups;
+    /* Left at 0, failing messages are retried by should_retry() */
+    context->i2c_adapter.retries = 0;
 
-    snprintf(context->i2c_adapter.name, sizeof(context->i2c_adapter.name), "AURA GPU adapter");
+    snprintf(context->i2c_adapter.name, sizeof(context->i2c_adapter.name), "AURA GPU adapter %s line %u", pci_name(pci_dev), line->number);
     i2c_set_adapdata(&context->i2c_adapter, context);
 
+    if (use_irq && pci_dev->irq) {
+        err = request_irq(pci_dev->irq, aura_gpu_i2c_irq, IRQF_SHARED, "aura-gpu-i2c", context);
+        if (err)
+            AURA_ERR("Failed to share irq %d, using a timer: %d", pci_dev->irq, err);
+        else
+            context->irq = pci_dev->irq;
+    }
+
     // TODO - Do we really need to expose this?
     err = i2c_add_adapter(&context->i2c_adapter);
     if (err)
-        goto error_free_registry;
+        goto error_free_irq;
+
+    aura_stats_publish(context->stats, &context->i2c_adapter);
+
+    context->queue = aura_i2c_queue_create(&context->i2c_adapter, &aura_gpu_i2c_queue_ops);
+    if (IS_ERR(context->queue)) {
+        err = PTR_ERR(context->queue);
+        goto error_del_adapter;
+    }
 
     return context;
 
-error_free_registry:
-    aura_gpu_reg_destroy(registry);
+error_del_adapter:
+    i2c_del_adapter(&context->i2c_adapter);
+    detach_engine(context);
+error_free_irq:
+    if (context->irq)
+        free_irq(context->irq, context);
+    aura_stats_destroy(context->stats);
 error_free_context:
     kfree(context);
 
@@ -670,78 +1662,45 @@ void gpu_adapter_destroy (
     if (IS_NULL(i2c_adapter))
         return;
 
+    aura_i2c_queue_destroy(context->queue);
     i2c_del_adapter(&context->i2c_adapter);
-    aura_gpu_reg_destroy(context->reg_service);
-    kfree(context);
-}
-
-struct i2c_adapter *gpu_adapter_create (
-    void
-){
-    struct pci_dev *pci_dev;
-    const struct pci_device_id *match;
-    struct aura_i2c_context *context = NULL;
-
-    /* Handle the case of mixed GPU types */
-    pci_dev = NULL;
 
-    while (NULL != (pci_dev = pci_get_device(PCI_ANY_ID, PCI_ANY_ID, pci_dev))) {
-        match = pci_match_id(pciidlist, pci_dev);
-        if (match) {
-            AURA_DBG("Detected AURA capable GPU %x:%x", pci_dev->subsystem_vendor, pci_dev->subsystem_device);
+    /* Nothing can open the engine anymore, hand it back now */
+    detach_engine(context);
 
-            context = aura_gpu_i2c_context_create(pci_dev, match->driver_data);
-            if (!IS_ERR_OR_NULL(context))
-                return &context->i2c_adapter;
-        }
-    }
-
-    return NULL;
+    if (context->irq)
+        free_irq(context->irq, context);
+    aura_stats_destroy(context->stats);
+    kfree(context);
 }
 
-int gpu_adapters_create (
-    struct i2c_adapter *i2c_adapters[2],
-    uint8_t count
+/**
+ * gpu_adapter_create() - Creates an adapter driving one line
+ * @pci_dev: The GPU
+ * @engine: Shared by every adapter of @pci_dev
+ * @line: The line to drive, which must have its pins
+ */
+struct i2c_adapter *gpu_adapter_create (
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
 ){
-    struct pci_dev *pci_dev;
     const struct pci_device_id *match;
-    struct aura_i2c_context *context = NULL;
-    error_t err;
-    int found;
+    struct aura_i2c_context *context;
 
-    if (IS_NULL(i2c_adapters) || IS_FALSE(count == 2))
-        return -EINVAL;
+    if (IS_NULL(pci_dev, engine, line, engine->resources))
+        return ERR_PTR(-EINVAL);
 
-    /* Handle the case of mixed GPU types */
-    pci_dev = NULL;
-    found = 0;
-
-    while (NULL != (pci_dev = pci_get_device(PCI_ANY_ID, PCI_ANY_ID, pci_dev))) {
-        match = pci_match_id(pciidlist, pci_dev);
-        if (match) {
-            AURA_DBG("Detected AURA capable GPU %x:%x", pci_dev->subsystem_vendor, pci_dev->subsystem_device);
-
-            context = aura_gpu_i2c_context_create(pci_dev, match->driver_data);
-            if (IS_ERR(context)) {
-                err = CLEAR_ERR(context);
-                goto error_free;
-            }
-
-            if (context) {
-                i2c_adapters[found++] = &context->i2c_adapter;
-                if (found >= count)
-                    break;
-            }
-        }
-    }
+    if (!line->has_pins)
+        return ERR_PTR(-ENODEV);
 
-    return found;
+    match = pci_match_id(pciidlist, pci_dev);
+    if (!match)
+        return ERR_PTR(-ENODEV);
 
-error_free:
-    while (found > 0) {
-        found--;
-        gpu_adapter_destroy(i2c_adapters[found]);
-    }
+    context = aura_gpu_i2c_context_create(pci_dev, match->driver_data, engine, line);
+    if (IS_ERR(context))
+        return ERR_CAST(context);
 
-    return err;
+    return &context->i2c_adapter;
 }
@@ -3,19 +3,27 @@
 #define _UAPI_AURA_GPU_I2C_H
 
 #include "aura-gpu-reg.h"
+#include "aura-gpu-bios.h"
+#include "aura-gpu-backend.h"
 #include "asic/asic-types.h"
+#include "asic/asic-registers.h"
 
 struct i2c_adapter *gpu_adapter_create (
-    void
-);
-
-int gpu_adapters_create (
-    struct i2c_adapter *i2c_adapters[2],
-    uint8_t count
+    struct pci_dev *pci_dev,
+    struct aura_gpu_engine *engine,
+    const struct aura_gpu_line *line
 );
 
 void gpu_adapter_destroy (
     struct i2c_adapter *i2c_adapter
 );
 
+uint32_t aura_gpu_i2c_get_reference (
+    struct atom_bios *bios
+);
+
+const struct asic_context* aura_gpu_i2c_get_ddc_context (
+    enum aura_asic_type asic_type
+);
+
 #endif
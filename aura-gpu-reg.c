@@ -3,13 +3,31 @@
 
 #include "debug.h"
 #include "aura-gpu-reg.h"
+#include "aura-gpu-trace.h"
 
 #define mmMM_INDEX            0x0000
 #define mmMM_DATA             0x0001
 
+#define REG_CACHE_ENTRIES     8
+
+/*
+ * Shadow of a register only this driver writes. Bits in volatile_mask are
+ * changed by the hardware, self-clearing triggers for example, and are
+ * never kept in the shadow.
+ */
+struct reg_cache_entry {
+    uint32_t                reg;
+    uint32_t                value;
+    uint32_t                volatile_mask;
+    bool                    valid;
+};
+
 struct aura_reg_context {
     struct aura_reg_service service;
     spinlock_t              lock;
+    spinlock_t              cache_lock;
+    struct reg_cache_entry  cache[REG_CACHE_ENTRIES];
+    int                     cache_count;
     resource_size_t         base;
     resource_size_t         size;
     void __iomem            *data;
@@ -17,47 +35,129 @@ struct aura_reg_context {
     struct pci_dev          *pci_dev;
 };
 
-#if defined(DEBUG_GPU_REG)
-
-static const char *reg_name(uint32_t reg)
-{
-    /* NOTE - These names are only valid for polaris cards */
-    switch (reg) {
-        case 0x16f4:
-            return "GENERIC_I2C_CONTROL           ";
-        case 0x16f5:
-            return "GENERIC_I2C_INTERRUPT_CONTROL ";
-        case 0x16f6:
-            return "GENERIC_I2C_STATUS            ";
-        case 0x16f7:
-            return "GENERIC_I2C_SPEED             ";
-        case 0x16f8:
-            return "GENERIC_I2C_SETUP             ";
-        case 0x16f9:
-            return "GENERIC_I2C_TRANSACTION       ";
-        case 0x16fa:
-            return "GENERIC_I2C_DATA              ";
-        case 0x16fb:
-            return "GENERIC_I2C_PIN_SELECTION     ";
-        case 0x16fc:
-            return "GENERIC_I2C_PIN_DEBUG         ";
+static struct reg_cache_entry *reg_cache_find (
+    struct aura_reg_context *ctx,
+    uint32_t reg
+){
+    int i;
+
+    for (i = 0; i < ctx->cache_count; i++) {
+        if (ctx->cache[i].reg == reg)
+            return &ctx->cache[i];
     }
 
-    return "<null>";
+    return NULL;
 }
 
-#define log_reg_read(_reg, _value)\
-    AURA_DBG("Reg Read: %s %x", reg_name(_reg), _value);
+static bool reg_cache_get (
+    struct aura_reg_context *ctx,
+    uint32_t reg,
+    uint32_t *value
+){
+    struct reg_cache_entry *entry;
+    unsigned long flags;
+    bool found = false;
+
+    if (!READ_ONCE(ctx->cache_count))
+        return false;
+
+    spin_lock_irqsave(&ctx->cache_lock, flags);
+    entry = reg_cache_find(ctx, reg);
+    if (entry && entry->valid) {
+        *value = entry->value;
+        found = true;
+    }
+    spin_unlock_irqrestore(&ctx->cache_lock, flags);
 
-#define log_reg_write(_reg, _value)\
-    AURA_DBG("Reg Write: %s %x", reg_name(_reg), _value);
+    return found;
+}
 
-#else
+static void reg_cache_put (
+    struct aura_reg_context *ctx,
+    uint32_t reg,
+    uint32_t value
+){
+    struct reg_cache_entry *entry;
+    unsigned long flags;
 
-#define log_reg_read(_reg, _value)
-#define log_reg_write(_reg, _value)
+    if (!READ_ONCE(ctx->cache_count))
+        return;
 
-#endif
+    spin_lock_irqsave(&ctx->cache_lock, flags);
+    entry = reg_cache_find(ctx, reg);
+    if (entry) {
+        entry->value = value & ~entry->volatile_mask;
+        entry->valid = true;
+    }
+    spin_unlock_irqrestore(&ctx->cache_lock, flags);
+}
+
+/**
+ * reg_cache_declare() - Shadows a register for read-modify-write updates
+ * @service: Register service
+ * @reg: Register which nothing else writes while the caller owns it
+ * @volatile_mask: Bits the hardware changes on its own, read back as 0
+ *
+ * Writes go through to the hardware and refresh the shadow, updates then
+ * skip the read. The shadow starts out invalid.
+ *
+ * @return: Zero or -ENOSPC
+ */
+error_t reg_cache_declare (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    uint32_t volatile_mask
+){
+    struct aura_reg_context *ctx = container_of(service, struct aura_reg_context, service);
+    struct reg_cache_entry *entry;
+    unsigned long flags;
+    error_t err = 0;
+
+    if (IS_NULL(service))
+        return -EINVAL;
+
+    spin_lock_irqsave(&ctx->cache_lock, flags);
+
+    entry = reg_cache_find(ctx, reg);
+    if (!entry && ctx->cache_count < REG_CACHE_ENTRIES) {
+        entry = &ctx->cache[ctx->cache_count];
+        entry->reg = reg;
+        entry->valid = false;
+        WRITE_ONCE(ctx->cache_count, ctx->cache_count + 1);
+    }
+
+    if (entry)
+        entry->volatile_mask = volatile_mask;
+    else
+        err = -ENOSPC;
+
+    spin_unlock_irqrestore(&ctx->cache_lock, flags);
+
+    return err;
+}
+
+/**
+ * reg_cache_invalidate() - Drops every shadowed value
+ * @service: Register service
+ *
+ * To be called whenever the registers may have been written by someone
+ * else, such as on taking ownership of an engine.
+ */
+void reg_cache_invalidate (
+    struct aura_reg_service *service
+){
+    struct aura_reg_context *ctx = container_of(service, struct aura_reg_context, service);
+    unsigned long flags;
+    int i;
+
+    if (IS_NULL(service))
+        return;
+
+    spin_lock_irqsave(&ctx->cache_lock, flags);
+    for (i = 0; i < ctx->cache_count; i++)
+        ctx->cache[i].valid = false;
+    spin_unlock_irqrestore(&ctx->cache_lock, flags);
+}
 
 int32_t reg_read (
     struct aura_reg_service *service,
@@ -82,7 +182,7 @@ int32_t reg_read (
         spin_unlock_irqrestore(&ctx->lock, flags);
     }
 
-    log_reg_read(reg, ret);
+    trace_aura_reg_read(reg, ret);
 
     return ret;
 }
@@ -99,7 +199,7 @@ void reg_write (
         return;
     }
 
-    log_reg_write(reg, value);
+    trace_aura_reg_write(reg, value);
 
     if ((reg * 4) < ctx->size)
         writel(value, ((void __iomem *)ctx->data) + (reg * 4));
@@ -111,6 +211,95 @@ void reg_write (
         writel(value, ((void __iomem *)ctx->data) + (mmMM_DATA * 4));
         spin_unlock_irqrestore(&ctx->lock, flags);
     }
+
+    reg_cache_put(ctx, reg, value);
+}
+
+/**
+ * reg_write_seq() - Writes several values to the same register
+ * @service: Register service
+ * @reg: Target register, usually a FIFO or auto-incrementing window
+ * @values: Values in write order
+ * @count: Number of values
+ *
+ * Registers inside the BAR still cost one write per value, so this only
+ * saves accesses for registers behind MM_INDEX, where the index is
+ * programmed once and the values streamed through MM_DATA under a
+ * single lock.
+ */
+void reg_write_seq (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    const uint32_t *values,
+    size_t count
+){
+    struct aura_reg_context *ctx = container_of(service, struct aura_reg_context, service);
+    unsigned long flags;
+    size_t i;
+
+    if (unlikely(service == NULL)) {
+        AURA_ERR("mmio has not been configured");
+        return;
+    }
+
+    if ((reg * 4) < ctx->size) {
+        for (i = 0; i < count; i++) {
+            trace_aura_reg_write(reg, values[i]);
+            writel(values[i], ((void __iomem *)ctx->data) + (reg * 4));
+        }
+        return;
+    }
+
+    spin_lock_irqsave(&ctx->lock, flags);
+    writel((reg * 4), ((void __iomem *)ctx->data) + (mmMM_INDEX * 4));
+    for (i = 0; i < count; i++) {
+        trace_aura_reg_write(reg, values[i]);
+        writel(values[i], ((void __iomem *)ctx->data) + (mmMM_DATA * 4));
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+/**
+ * reg_read_seq() - Reads the same register several times
+ * @service: Register service
+ * @reg: Source register, usually a FIFO or auto-incrementing window
+ * @values: Receives the values in read order
+ * @count: Number of reads
+ *
+ * As with reg_write_seq() only registers behind MM_INDEX save the index
+ * write, registers inside the BAR are read once per value.
+ */
+void reg_read_seq (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    uint32_t *values,
+    size_t count
+){
+    struct aura_reg_context *ctx = container_of(service, struct aura_reg_context, service);
+    unsigned long flags;
+    size_t i;
+
+    if (unlikely(service == NULL)) {
+        AURA_ERR("mmio has not been configured");
+        memset(values, 0, count * sizeof(*values));
+        return;
+    }
+
+    if ((reg * 4) < ctx->size) {
+        for (i = 0; i < count; i++) {
+            values[i] = readl(((void __iomem *)ctx->data) + (reg * 4));
+            trace_aura_reg_read(reg, values[i]);
+        }
+        return;
+    }
+
+    spin_lock_irqsave(&ctx->lock, flags);
+    writel((reg * 4), ((void __iomem *)ctx->data) + (mmMM_INDEX * 4));
+    for (i = 0; i < count; i++) {
+        values[i] = readl(((void __iomem *)ctx->data) + (mmMM_DATA * 4));
+        trace_aura_reg_read(reg, values[i]);
+    }
+    spin_unlock_irqrestore(&ctx->lock, flags);
 }
 
 uint32_t reg_field_get_value_ex(
@@ -134,6 +323,7 @@ uint32_t reg_update_ex(
     const struct reg_fields *fields,
     ssize_t cnt
 ){
+    struct aura_reg_context *ctx = container_of(service, struct aura_reg_context, service);
     uint32_t ret;
     uint32_t value = 0, mask = 0;
 
@@ -146,8 +336,9 @@ uint32_t reg_update_ex(
         cnt--;
     }
 
-    /* mmio write directly */
-    ret = reg_read(service, addr);
+    /* Shadowed registers skip the read */
+    if (!reg_cache_get(ctx, addr, &ret))
+        ret = reg_read(service, addr);
     ret = (ret & ~mask) | value;
 
     reg_write(service, addr, ret);
@@ -271,6 +462,7 @@ struct aura_reg_service *aura_gpu_reg_create(
         goto error;
 
     spin_lock_init(&ctx->lock);
+    spin_lock_init(&ctx->cache_lock);
 
     ctx->pci_dev = pci_dev;
     ctx->base    = pci_resource_start(pci_dev, 5);
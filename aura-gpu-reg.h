@@ -32,6 +32,18 @@ void reg_write (
     uint32_t reg,
     uint32_t value
 );
+void reg_write_seq (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    const uint32_t *values,
+    size_t count
+);
+void reg_read_seq (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    uint32_t *values,
+    size_t count
+);
 
 uint32_t reg_get_field_value(
     const struct reg_fields *field
@@ -92,6 +104,15 @@ void reg_wait_ex(
     uint32_t timeout
 );
 
+error_t reg_cache_declare (
+    struct aura_reg_service *service,
+    uint32_t reg,
+    uint32_t volatile_mask
+);
+void reg_cache_invalidate (
+    struct aura_reg_service *service
+);
+
 struct aura_reg_service *aura_gpu_reg_create(
     struct pci_dev *pci_dev
 );
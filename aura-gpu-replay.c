@@ -0,0 +1,840 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/delay.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+
+#include "debug.h"
+#include "aura-gpu-replay.h"
+
+/*
+ * Record and replay of AtomBIOS command tables.
+ *
+ * A table run is traced at the card_info level, with consecutive reads of
+ * the same register (optionally separated by a delay) folded into a single
+ * polling event. Once a second trace of the same shape lines up with the
+ * first, each register write is expressed either as a constant or as a
+ * constant with one parameter byte shifted into it, and each poll as an exit
+ * condition. The result is verified against further interpreted runs before
+ * it is replayed directly against the card.
+ *
+ * Replay guards every read. When a read does not match what was recorded
+ * before any register has been written, the program is discarded and the call
+ * is re-run through the interpreter. Once a write has been made the hardware
+ * has acted on it, so running the table again would repeat the transaction.
+ * The call instead completes with the table's failure result.
+ *
+ * Contents of the FB scratch window are not tracked, so a table which
+ * touches it cannot be replayed. The I2C table returns read data through
+ * that window, which leaves only writes and probes to be replayed. A shape
+ * is given up on the first time it touches the window, rather than being
+ * retried as if the trace were merely inconsistent.
+ */
+
+#define REPLAY_SLOTS            8
+#define REPLAY_MAX_EVENTS       64
+#define REPLAY_MAX_WAITS        4
+#define REPLAY_MAX_PARAMS       16
+#define REPLAY_VERIFY_RUNS      2
+#define REPLAY_MAX_FAILURES     8
+#define REPLAY_NO_SOURCE        0xff
+
+static bool replay_enable = true;
+module_param_named(replay, replay_enable, bool, 0644);
+MODULE_PARM_DESC(replay, "Replay compiled traces of the BIOS I2C table (default: true)");
+
+enum replay_event_type {
+    REPLAY_READ,
+    REPLAY_WRITE,
+    REPLAY_DELAY,
+};
+
+struct replay_event {
+    uint8_t  type;
+    uint8_t  source;                    /* write: parameter byte shifted into value */
+    uint8_t  shift;
+    uint8_t  wait_count;
+    uint32_t reg;
+    uint32_t value;                     /* read: exit value, delay: microseconds */
+    uint32_t mask;                      /* read: bits deciding the exit */
+    uint32_t delay;                     /* read: microseconds between polls */
+    uint32_t iterations;                /* read: most polls seen */
+    uint32_t wait[REPLAY_MAX_WAITS];    /* read: values seen before the exit */
+};
+
+struct replay_trace {
+    uint8_t             in[REPLAY_MAX_PARAMS];
+    uint8_t             out[REPLAY_MAX_PARAMS];
+    bool                tainted;
+    bool                scratch;        /* touched the FB window */
+    int                 count;
+    struct replay_event events[REPLAY_MAX_EVENTS];
+};
+
+enum replay_state {
+    REPLAY_FREE,        /* slot holds no shape */
+    REPLAY_LEARNING,    /* holds a shape but no trace */
+    REPLAY_PENDING,     /* holds a single reference trace */
+    REPLAY_CANDIDATE,   /* holds a program being verified */
+    REPLAY_ACTIVE,      /* holds a program being replayed */
+    REPLAY_BROKEN,      /* shape can never be compiled */
+};
+
+struct replay_slot {
+    enum replay_state   state;
+    uint8_t             key[REPLAY_MAX_PARAMS];
+    unsigned long       last_used;
+    int                 verified;
+    int                 failures;
+    uint32_t            varied;         /* data bytes seen to change */
+    uint32_t            passthru;       /* output bytes equal to their input */
+    struct replay_trace *trace;
+};
+
+struct aura_replay {
+    struct atom_context *atom;
+    struct card_info    *real;
+    struct card_info    card;
+    struct atom_hooks   hooks;
+    int                 index;
+    uint32_t            size;
+    uint32_t            vary;
+    uint32_t            result;
+    uint8_t             failure;
+    unsigned long       tick;
+    struct replay_trace *recording;
+    struct replay_slot  slots[REPLAY_SLOTS];
+};
+#define replay_from_card(ptr) ( \
+    container_of(ptr, struct aura_replay, card) \
+)
+#define replay_from_hooks(ptr) ( \
+    container_of(ptr, struct aura_replay, hooks) \
+)
+
+static void replay_delay (
+    uint32_t usec
+){
+    if (usec >= 1000)
+        msleep(usec / 1000);
+    else if (usec)
+        udelay(usec);
+}
+
+static struct replay_event *replay_append (
+    struct replay_trace *trace,
+    enum replay_event_type type,
+    uint32_t reg,
+    uint32_t value
+){
+    struct replay_event *event;
+
+    if (trace->count >= REPLAY_MAX_EVENTS) {
+        trace->tainted = true;
+        return NULL;
+    }
+
+    event = &trace->events[trace->count++];
+    memset(event, 0, sizeof(*event));
+    event->type = type;
+    event->reg = reg;
+    event->value = value;
+    event->source = REPLAY_NO_SOURCE;
+
+    return event;
+}
+
+static bool replay_add_wait (
+    struct replay_event *event,
+    uint32_t value
+){
+    int i;
+
+    for (i = 0; i < event->wait_count; i++) {
+        if (event->wait[i] == value)
+            return true;
+    }
+
+    if (event->wait_count >= REPLAY_MAX_WAITS)
+        return false;
+
+    event->wait[event->wait_count++] = value;
+
+    return true;
+}
+
+static void replay_record_read (
+    struct replay_trace *trace,
+    uint32_t reg,
+    uint32_t value
+){
+    struct replay_event *last = trace->count ? &trace->events[trace->count - 1] : NULL;
+
+    if (trace->tainted)
+        return;
+
+    /* A delay between two reads of one register is the body of a poll loop */
+    if (last && last->type == REPLAY_DELAY && trace->count >= 2 &&
+        last[-1].type == REPLAY_READ && last[-1].reg == reg) {
+        if (last[-1].delay && last[-1].delay != last->value) {
+            trace->tainted = true;
+            return;
+        }
+
+        last[-1].delay = last->value;
+        trace->count--;
+        last--;
+    }
+
+    if (last && last->type == REPLAY_READ && last->reg == reg) {
+        if (last->value != value && !replay_add_wait(last, last->value)) {
+            trace->tainted = true;
+            return;
+        }
+
+        last->value = value;
+        last->iterations++;
+        return;
+    }
+
+    last = replay_append(trace, REPLAY_READ, reg, value);
+    if (last)
+        last->iterations = 1;
+}
+
+static uint32_t replay_reg_read (
+    struct card_info *card,
+    uint32_t reg
+){
+    struct aura_replay *replay = replay_from_card(card);
+    uint32_t value = replay->real->reg_read(replay->real, reg);
+
+    replay_record_read(replay->recording, reg, value);
+
+    return value;
+}
+
+static void replay_reg_write (
+    struct card_info *card,
+    uint32_t reg,
+    uint32_t value
+){
+    struct aura_replay *replay = replay_from_card(card);
+
+    if (!replay->recording->tainted)
+        replay_append(replay->recording, REPLAY_WRITE, reg, value);
+
+    replay->real->reg_write(replay->real, reg, value);
+}
+
+/* Only MM register accesses can be replayed */
+#define REPLAY_TAINTED_IO(_name)                                \
+static uint32_t replay_##_name##_read (                         \
+    struct card_info *card,                                     \
+    uint32_t reg                                                \
+){                                                              \
+    struct aura_replay *replay = replay_from_card(card);        \
+    replay->recording->tainted = true;                          \
+    return replay->real->_name##_read(replay->real, reg);       \
+}                                                               \
+static void replay_##_name##_write (                            \
+    struct card_info *card,                                     \
+    uint32_t reg,                                               \
+    uint32_t value                                              \
+){                                                              \
+    struct aura_replay *replay = replay_from_card(card);        \
+    replay->recording->tainted = true;                          \
+    replay->real->_name##_write(replay->real, reg, value);      \
+}
+
+REPLAY_TAINTED_IO(ioreg)
+REPLAY_TAINTED_IO(mc)
+REPLAY_TAINTED_IO(pll)
+
+static void replay_hook_delay (
+    struct atom_hooks *hooks,
+    uint32_t usec
+){
+    struct aura_replay *replay = replay_from_hooks(hooks);
+
+    if (!replay->recording->tainted)
+        replay_append(replay->recording, REPLAY_DELAY, 0, usec);
+}
+
+static void replay_hook_fb_access (
+    struct atom_hooks *hooks,
+    uint32_t index,
+    bool write
+){
+    struct aura_replay *replay = replay_from_hooks(hooks);
+
+    /* Scratch contents are not tracked, so the trace is unusable */
+    replay->recording->tainted = true;
+    replay->recording->scratch = true;
+}
+
+static uint32_t replay_predict (
+    const struct replay_event *event,
+    const uint8_t *in
+){
+    if (event->source == REPLAY_NO_SOURCE)
+        return event->value;
+
+    return event->value | ((uint32_t)in[event->source] << event->shift);
+}
+
+/*
+ * Finds a template for a write which explains the values seen in two traces
+ * made with different data bytes.
+ */
+static bool replay_fit_write (
+    struct replay_event *event,
+    const struct replay_trace *a,
+    const struct replay_event *ea,
+    const struct replay_trace *b,
+    const struct replay_event *eb,
+    uint32_t varied
+){
+    uint32_t mask;
+    int source, shift;
+
+    event->source = REPLAY_NO_SOURCE;
+    event->value = ea->value;
+
+    if (ea->value == eb->value)
+        return true;
+
+    for (source = 0; source < REPLAY_MAX_PARAMS; source++) {
+        if (!(varied & BIT(source)))
+            continue;
+
+        for (shift = 0; shift < 32; shift += 8) {
+            mask = 0xff << shift;
+
+            if ((ea->value & ~mask) != (eb->value & ~mask))
+                continue;
+            if (((ea->value >> shift) & 0xff) != a->in[source])
+                continue;
+            if (((eb->value >> shift) & 0xff) != b->in[source])
+                continue;
+
+            event->source = source;
+            event->shift = shift;
+            event->value = ea->value & ~mask;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool replay_is_exit (
+    const struct replay_event *event,
+    uint32_t value
+){
+    return (value & event->mask) == (event->value & event->mask);
+}
+
+static bool replay_is_wait (
+    const struct replay_event *event,
+    uint32_t value
+){
+    int i;
+
+    for (i = 0; i < event->wait_count; i++) {
+        if ((value & event->mask) == (event->wait[i] & event->mask))
+            return true;
+    }
+
+    return false;
+}
+
+static bool replay_merge_read (
+    struct replay_event *event,
+    const struct replay_event *other
+){
+    int i;
+
+    for (i = 0; i < other->wait_count; i++) {
+        if (!replay_add_wait(event, other->wait[i]))
+            return false;
+    }
+
+    if (!event->delay)
+        event->delay = other->delay;
+    else if (other->delay && other->delay != event->delay)
+        return false;
+
+    event->iterations = max(event->iterations, other->iterations);
+
+    /* Only the bits which changed when the poll finished decide the exit */
+    event->mask = 0;
+    for (i = 0; i < event->wait_count; i++)
+        event->mask |= event->wait[i] ^ event->value;
+    if (!event->wait_count)
+        event->mask = ~0;
+
+    for (i = 0; i < event->wait_count; i++) {
+        if (replay_is_exit(event, event->wait[i]))
+            return false;
+    }
+
+    return replay_is_exit(event, other->value);
+}
+
+static uint32_t replay_diff (
+    struct aura_replay *replay,
+    const uint8_t *a,
+    const uint8_t *b
+){
+    uint32_t diff = 0;
+    int i;
+
+    for (i = 0; i < replay->size; i++) {
+        if (a[i] != b[i])
+            diff |= BIT(i);
+    }
+
+    return diff & replay->vary;
+}
+
+/*
+ * Turns the reference trace held by the slot into a program, using a second
+ * trace to find which values depend on the data bytes.
+ */
+static bool replay_compile (
+    struct aura_replay *replay,
+    struct replay_slot *slot,
+    const struct replay_trace *other
+){
+    struct replay_trace *ref = slot->trace;
+    struct replay_event *event;
+    const struct replay_event *oe;
+    int i;
+
+    if (ref->count != other->count)
+        return false;
+
+    slot->varied = replay_diff(replay, ref->in, other->in);
+
+    for (i = 0; i < ref->count; i++) {
+        event = &ref->events[i];
+        oe = &other->events[i];
+
+        if (event->type != oe->type || event->reg != oe->reg)
+            return false;
+
+        switch (event->type) {
+        case REPLAY_READ:
+            if (!replay_merge_read(event, oe))
+                return false;
+            break;
+        case REPLAY_WRITE:
+            if (!replay_fit_write(event, ref, event, other, oe, slot->varied))
+                return false;
+            break;
+        case REPLAY_DELAY:
+            if (event->value != oe->value)
+                return false;
+            break;
+        }
+    }
+
+    slot->passthru = 0;
+    for (i = 0; i < replay->size; i++) {
+        if (ref->out[i] == ref->in[i] && other->out[i] == other->in[i])
+            slot->passthru |= BIT(i);
+        else if (ref->out[i] != other->out[i])
+            return false;
+    }
+
+    return true;
+}
+
+static bool replay_verify (
+    struct aura_replay *replay,
+    struct replay_slot *slot,
+    const struct replay_trace *other
+){
+    struct replay_trace *prog = slot->trace;
+    struct replay_event *event;
+    const struct replay_event *oe;
+    int i, w;
+
+    if (prog->count != other->count)
+        return false;
+
+    for (i = 0; i < prog->count; i++) {
+        event = &prog->events[i];
+        oe = &other->events[i];
+
+        if (event->type != oe->type || event->reg != oe->reg)
+            return false;
+
+        switch (event->type) {
+        case REPLAY_READ:
+            if (!replay_is_exit(event, oe->value))
+                return false;
+            for (w = 0; w < oe->wait_count; w++) {
+                if (!replay_is_wait(event, oe->wait[w]))
+                    return false;
+            }
+            if (oe->delay && event->delay && oe->delay != event->delay)
+                return false;
+            break;
+        case REPLAY_WRITE:
+            if (replay_predict(event, other->in) != oe->value)
+                return false;
+            break;
+        case REPLAY_DELAY:
+            if (event->value != oe->value)
+                return false;
+            break;
+        }
+    }
+
+    for (i = 0; i < replay->size; i++) {
+        if (slot->passthru & BIT(i)) {
+            if (other->out[i] != other->in[i])
+                return false;
+        } else if (other->out[i] != prog->out[i]) {
+            return false;
+        }
+    }
+
+    /* Only now is it safe to widen what the program accepts */
+    for (i = 0; i < prog->count; i++) {
+        event = &prog->events[i];
+        oe = &other->events[i];
+
+        if (event->type != REPLAY_READ)
+            continue;
+
+        event->iterations = max(event->iterations, oe->iterations);
+        if (!event->delay)
+            event->delay = oe->delay;
+    }
+
+    slot->varied |= replay_diff(replay, prog->in, other->in);
+
+    return true;
+}
+
+/*
+ * Runs a compiled program. Returns -EAGAIN when a guard fails before anything
+ * was written, in which case the caller must fall back to the interpreter, or
+ * -EIO when it fails afterwards, with the failure result already stored.
+ */
+static error_t replay_run (
+    struct aura_replay *replay,
+    struct replay_slot *slot,
+    uint8_t *params
+){
+    struct card_info *card = replay->real;
+    struct replay_trace *prog = slot->trace;
+    struct replay_event *event;
+    uint32_t value, limit, i;
+    bool written = false;
+    int step;
+
+    for (step = 0; step < prog->count; step++) {
+        event = &prog->events[step];
+
+        switch (event->type) {
+        case REPLAY_WRITE:
+            card->reg_write(card, event->reg, replay_predict(event, params));
+            written = true;
+            break;
+        case REPLAY_DELAY:
+            replay_delay(event->value);
+            break;
+        case REPLAY_READ:
+            limit = event->iterations * 4 + 4;
+            for (i = 0; ; i++) {
+                value = card->reg_read(card, event->reg);
+                if (replay_is_exit(event, value))
+                    break;
+                if (i >= limit || !replay_is_wait(event, value))
+                    goto guard_failed;
+                replay_delay(event->delay);
+            }
+            break;
+        }
+    }
+
+    for (i = 0; i < replay->size; i++) {
+        if (!(slot->passthru & BIT(i)))
+            params[i] = prog->out[i];
+    }
+
+    return 0;
+
+guard_failed:
+    if (!written)
+        return -EAGAIN;
+
+    params[replay->result] = replay->failure;
+
+    return -EIO;
+}
+
+static struct replay_slot *replay_find_slot (
+    struct aura_replay *replay,
+    const uint8_t *key
+){
+    struct replay_slot *slot, *victim = NULL;
+    int i;
+
+    for (i = 0; i < REPLAY_SLOTS; i++) {
+        slot = &replay->slots[i];
+
+        if (slot->state != REPLAY_FREE && !memcmp(slot->key, key, replay->size))
+            goto found;
+
+        /* Free slots have never been used, so sort before any other */
+        if (!victim || slot->last_used < victim->last_used)
+            victim = slot;
+    }
+
+    slot = victim;
+    slot->state = REPLAY_LEARNING;
+    slot->verified = 0;
+    slot->failures = 0;
+    memcpy(slot->key, key, replay->size);
+
+found:
+    slot->last_used = ++replay->tick;
+
+    return slot;
+}
+
+static void replay_slot_fail (
+    struct replay_slot *slot
+){
+    if (++slot->failures >= REPLAY_MAX_FAILURES) {
+        AURA_DBG("Giving up on compiling table shape");
+        slot->state = REPLAY_BROKEN;
+        return;
+    }
+
+    slot->state = REPLAY_LEARNING;
+}
+
+/*
+ * Feeds a fresh trace into the slot's state machine.
+ */
+static void replay_learn (
+    struct aura_replay *replay,
+    struct replay_slot *slot,
+    const struct replay_trace *trace
+){
+    /* Every run of the shape will touch it again */
+    if (trace->scratch) {
+        AURA_DBG("Table shape uses the scratch window, not replaying it");
+        slot->state = REPLAY_BROKEN;
+        return;
+    }
+
+    if (trace->tainted) {
+        replay_slot_fail(slot);
+        return;
+    }
+
+    switch (slot->state) {
+    case REPLAY_PENDING:
+        if (replay_compile(replay, slot, trace)) {
+            slot->state = REPLAY_CANDIDATE;
+            slot->verified = 0;
+            return;
+        }
+        break;
+    case REPLAY_CANDIDATE:
+    case REPLAY_ACTIVE:
+        if (replay_verify(replay, slot, trace)) {
+            if (++slot->verified >= REPLAY_VERIFY_RUNS)
+                slot->state = REPLAY_ACTIVE;
+            return;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (slot->state != REPLAY_LEARNING)
+        replay_slot_fail(slot);
+
+    if (slot->state == REPLAY_BROKEN)
+        return;
+
+    if (!slot->trace) {
+        slot->trace = kmalloc(sizeof(*slot->trace), GFP_KERNEL);
+        if (!slot->trace)
+            return;
+    }
+
+    memcpy(slot->trace, trace, sizeof(*trace));
+    slot->state = REPLAY_PENDING;
+}
+
+static error_t replay_interpret (
+    struct aura_replay *replay,
+    struct replay_slot *slot,
+    uint32_t *params
+){
+    struct replay_trace *trace = replay->recording;
+    struct card_info *real = replay->atom->card;
+    error_t err;
+
+    trace->count = 0;
+    trace->tainted = false;
+    trace->scratch = false;
+    memcpy(trace->in, params, replay->size);
+
+    replay->real = real;
+    replay->atom->card = &replay->card;
+    replay->atom->hooks = &replay->hooks;
+
+    err = __atom_execute_table(replay->atom, replay->index, params);
+
+    replay->atom->hooks = NULL;
+    replay->atom->card = real;
+
+    if (err)
+        return err;
+
+    memcpy(trace->out, params, replay->size);
+    replay_learn(replay, slot, trace);
+
+    return 0;
+}
+
+error_t aura_replay_execute (
+    struct aura_replay *replay,
+    uint32_t *params
+){
+    struct replay_slot *slot;
+    uint8_t key[REPLAY_MAX_PARAMS];
+    uint32_t fixed;
+    error_t err;
+    int i;
+
+    mutex_lock(&replay->atom->mutex);
+
+    if (!replay_enable) {
+        err = __atom_execute_table(replay->atom, replay->index, params);
+        goto done;
+    }
+
+    memcpy(key, params, replay->size);
+    for (i = 0; i < replay->size; i++) {
+        if (replay->vary & BIT(i))
+            key[i] = 0;
+    }
+
+    slot = replay_find_slot(replay, key);
+
+    switch (slot->state) {
+    case REPLAY_BROKEN:
+        err = __atom_execute_table(replay->atom, replay->index, params);
+        goto done;
+    case REPLAY_ACTIVE:
+        /* Data bytes which never changed while learning must still match */
+        fixed = replay->vary & ~slot->varied;
+        if (replay_diff(replay, (uint8_t *)params, slot->trace->in) & fixed)
+            break;
+
+        replay->real = replay->atom->card;
+        err = replay_run(replay, slot, (uint8_t *)params);
+        if (!err) {
+            slot->failures = 0;
+            goto done;
+        }
+
+        replay_slot_fail(slot);
+
+        /* The hardware has seen the transaction, report it as failed */
+        if (err != -EAGAIN) {
+            AURA_DBG("Replay guard failed after a write");
+            err = 0;
+            goto done;
+        }
+
+        AURA_DBG("Replay guard failed, falling back to the interpreter");
+        break;
+    default:
+        break;
+    }
+
+    err = replay_interpret(replay, slot, params);
+
+done:
+    mutex_unlock(&replay->atom->mutex);
+
+    return err;
+}
+
+struct aura_replay *aura_replay_create (
+    struct atom_context *atom,
+    int index,
+    uint32_t size,
+    uint32_t vary,
+    uint32_t result,
+    uint8_t failure
+){
+    struct aura_replay *replay;
+
+    if (IS_NULL(atom))
+        return ERR_PTR(-EINVAL);
+
+    if (size > REPLAY_MAX_PARAMS)
+        return ERR_PTR(-E2BIG);
+
+    if (result >= size)
+        return ERR_PTR(-EINVAL);
+
+    replay = kzalloc(sizeof(*replay), GFP_KERNEL);
+    if (!replay)
+        return ERR_PTR(-ENOMEM);
+
+    replay->recording = kzalloc(sizeof(*replay->recording), GFP_KERNEL);
+    if (!replay->recording) {
+        kfree(replay);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    replay->atom    = atom;
+    replay->index   = index;
+    replay->size    = size;
+    replay->vary    = vary;
+    replay->result  = result;
+    replay->failure = failure;
+
+    replay->card.reg_read    = replay_reg_read;
+    replay->card.reg_write   = replay_reg_write;
+    replay->card.ioreg_read  = replay_ioreg_read;
+    replay->card.ioreg_write = replay_ioreg_write;
+    replay->card.mc_read     = replay_mc_read;
+    replay->card.mc_write    = replay_mc_write;
+    replay->card.pll_read    = replay_pll_read;
+    replay->card.pll_write   = replay_pll_write;
+
+    replay->hooks.delay      = replay_hook_delay;
+    replay->hooks.fb_access  = replay_hook_fb_access;
+
+    return replay;
+}
+
+void aura_replay_destroy (
+    struct aura_replay *replay
+){
+    int i;
+
+    if (IS_NULL(replay))
+        return;
+
+    for (i = 0; i < REPLAY_SLOTS; i++)
+        kfree(replay->slots[i].trace);
+
+    kfree(replay->recording);
+    kfree(replay);
+}
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _UAPI_AURA_GPU_REPLAY_H
+#define _UAPI_AURA_GPU_REPLAY_H
+
+#include <linux/types.h>
+#include "include/types.h"
+#include "atom/atom.h"
+
+struct aura_replay;
+
+/**
+ * aura_replay_create() - Creates a replay cache for a single command table
+ * @atom: Parsed BIOS context the table belongs to
+ * @index: Index of the command table
+ * @size: Size, in bytes, of the table's parameter block
+ * @vary: Bitmask of parameter bytes which carry data rather than shape
+ * @result: Offset of the parameter byte the table reports its result in
+ * @failure: Value stored at @result when a replay fails part way through
+ *
+ * Parameter bytes not set in @vary make up the shape of a call. Every shape
+ * is traced and, once two traces agree, compiled into a list of register
+ * accesses which is replayed instead of being interpreted.
+ *
+ * @return: A new cache or an ERR_PTR
+ */
+struct aura_replay *aura_replay_create (
+    struct atom_context *atom,
+    int index,
+    uint32_t size,
+    uint32_t vary,
+    uint32_t result,
+    uint8_t failure
+);
+
+void aura_replay_destroy (
+    struct aura_replay *replay
+);
+
+/**
+ * aura_replay_execute() - Drop in replacement for atom_execute_table
+ * @replay: Cache created with aura_replay_create
+ * @params: Parameter block of the table
+ *
+ * @return: Zero or a negative error number
+ */
+error_t aura_replay_execute (
+    struct aura_replay *replay,
+    uint32_t *params
+);
+
+#endif
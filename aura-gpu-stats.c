@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+#include "debug.h"
+#include "aura-gpu-stats.h"
+
+/*
+ * Every counter lives in per-cpu storage and is only ever incremented by
+ * the local cpu. Readers sum all cpus, so a snapshot may be slightly torn
+ * between counters but never loses an increment.
+ */
+
+static struct dentry *aura_stats_root;
+
+static const char * const aura_stat_names[AURA_STAT_COUNT] = {
+    [AURA_STAT_XFERS]               = "xfers",
+    [AURA_STAT_XFER_ERRORS]         = "xfer_errors",
+    [AURA_STAT_MESSAGES]            = "messages",
+    [AURA_STAT_BYTES]               = "bytes",
+    [AURA_STAT_BIOS_TRANSACTIONS]   = "bios_transactions",
+    [AURA_STAT_BIOS_FAILURE]        = "bios_failure",
+    [AURA_STAT_PROBE_CACHE_HITS]    = "probe_cache_hits",
+    [AURA_STAT_TIMEOUT]             = "timeout",
+    [AURA_STAT_NO_RESPONSE]         = "no_response",
+    [AURA_STAT_ENGINE_BUSY]         = "engine_busy",
+    [AURA_STAT_ABORTED]             = "aborted",
+    [AURA_STAT_RETRIES]             = "retries",
+    [AURA_STAT_RETRIES_EXHAUSTED]   = "retries_exhausted",
+    [AURA_STAT_CONTENTION]          = "contention",
+    [AURA_STAT_BUS_RECOVERIES]      = "bus_recoveries",
+    [AURA_STAT_RECOVERY_FAILURES]   = "recovery_failures",
+};
+
+static const char * const aura_hist_names[AURA_HIST_COUNT] = {
+    [AURA_HIST_XFER]                = "xfer",
+    [AURA_HIST_BIOS_TRANSACTION]    = "bios_transaction",
+    [AURA_HIST_POLL]                = "poll",
+    [AURA_HIST_RECOVERY]            = "recovery",
+};
+
+#define aura_stats_sum(_stats, _field) ({                       \
+    u64 ___sum = 0;                                             \
+    int ___cpu;                                                 \
+    for_each_possible_cpu(___cpu)                               \
+        ___sum += per_cpu_ptr((_stats)->cpu, ___cpu)->_field;   \
+    ___sum;                                                     \
+})
+
+static int counters_show (
+    struct seq_file *seq,
+    void *data
+){
+    struct aura_stats *stats = seq->private;
+    int i;
+
+    for (i = 0; i < AURA_STAT_COUNT; i++)
+        seq_printf(seq, "%-20s %llu\n", aura_stat_names[i], aura_stats_sum(stats, counters[i]));
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(counters);
+
+static int histograms_show (
+    struct seq_file *seq,
+    void *data
+){
+    struct aura_stats *stats = seq->private;
+    int i, b;
+
+    for (i = 0; i < AURA_HIST_COUNT; i++) {
+        seq_printf(seq, "%s:\n", aura_hist_names[i]);
+
+        for (b = 0; b < AURA_HIST_BUCKETS; b++) {
+            if (b == AURA_HIST_BUCKETS - 1)
+                seq_printf(seq, "  >= %8u us", 1u << (b - 1));
+            else
+                seq_printf(seq, "  <  %8u us", 1u << b);
+
+            seq_printf(seq, " %llu\n", aura_stats_sum(stats, hist[i][b]));
+        }
+    }
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(histograms);
+
+static int addresses_show (
+    struct seq_file *seq,
+    void *data
+){
+    struct aura_stats *stats = seq->private;
+    u64 xfers;
+    int addr;
+
+    seq_puts(seq, "addr xfers errors\n");
+
+    for (addr = 0; addr < AURA_STATS_ADDRESSES; addr++) {
+        xfers = aura_stats_sum(stats, addr_xfers[addr]);
+        if (!xfers)
+            continue;
+
+        seq_printf(seq, "0x%02x %llu %llu\n", addr, xfers, aura_stats_sum(stats, addr_errors[addr]));
+    }
+
+    return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(addresses);
+
+struct aura_stats *aura_stats_create (
+    void
+){
+    struct aura_stats *stats = kzalloc(sizeof(*stats), GFP_KERNEL);
+
+    if (!stats)
+        return ERR_PTR(-ENOMEM);
+
+    stats->cpu = alloc_percpu(struct aura_stats_cpu);
+    if (!stats->cpu) {
+        kfree(stats);
+        return ERR_PTR(-ENOMEM);
+    }
+
+    return stats;
+}
+
+/**
+ * aura_stats_publish() - Exposes the statistics in debugfs
+ * @stats: Statistics of @adapter
+ * @adapter: A registered adapter, names the directory
+ *
+ * Failing to create the files is not fatal, the counters keep running.
+ */
+void aura_stats_publish (
+    struct aura_stats *stats,
+    struct i2c_adapter *adapter
+){
+    if (IS_NULL(stats, adapter) || !aura_stats_root)
+        return;
+
+    stats->dir = debugfs_create_dir(dev_name(&adapter->dev), aura_stats_root);
+    if (IS_ERR_OR_NULL(stats->dir)) {
+        stats->dir = NULL;
+        return;
+    }
+
+    debugfs_create_file("counters", 0444, stats->dir, stats, &counters_fops);
+    debugfs_create_file("histograms", 0444, stats->dir, stats, &histograms_fops);
+    debugfs_create_file("addresses", 0444, stats->dir, stats, &addresses_fops);
+}
+
+void aura_stats_destroy (
+    struct aura_stats *stats
+){
+    if (IS_NULL(stats))
+        return;
+
+    debugfs_remove_recursive(stats->dir);
+    free_percpu(stats->cpu);
+    kfree(stats);
+}
+
+error_t aura_stats_init (
+    void
+){
+    aura_stats_root = debugfs_create_dir("aura-gpu", NULL);
+    if (IS_ERR(aura_stats_root))
+        aura_stats_root = NULL;
+
+    return 0;
+}
+
+void aura_stats_exit (
+    void
+){
+    debugfs_remove_recursive(aura_stats_root);
+    aura_stats_root = NULL;
+}
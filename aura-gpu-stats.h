@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _UAPI_AURA_GPU_STATS_H
+#define _UAPI_AURA_GPU_STATS_H
+
+#include <linux/i2c.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/percpu.h>
+#include "include/types.h"
+
+enum aura_stat {
+    AURA_STAT_XFERS,
+    AURA_STAT_XFER_ERRORS,
+    AURA_STAT_MESSAGES,
+    AURA_STAT_BYTES,
+    AURA_STAT_BIOS_TRANSACTIONS,
+    AURA_STAT_BIOS_FAILURE,
+    AURA_STAT_PROBE_CACHE_HITS,
+    AURA_STAT_TIMEOUT,
+    AURA_STAT_NO_RESPONSE,
+    AURA_STAT_ENGINE_BUSY,
+    AURA_STAT_ABORTED,
+    AURA_STAT_RETRIES,
+    AURA_STAT_RETRIES_EXHAUSTED,
+    AURA_STAT_CONTENTION,
+    AURA_STAT_BUS_RECOVERIES,
+    AURA_STAT_RECOVERY_FAILURES,
+
+    AURA_STAT_COUNT
+};
+
+enum aura_hist {
+    AURA_HIST_XFER,
+    AURA_HIST_BIOS_TRANSACTION,
+    AURA_HIST_POLL,
+    AURA_HIST_RECOVERY,
+
+    AURA_HIST_COUNT
+};
+
+/* Bucket n counts latencies below 2^n microseconds, the last is unbounded */
+#define AURA_HIST_BUCKETS       21
+#define AURA_STATS_ADDRESSES    0x80
+
+struct aura_stats_cpu {
+    u64 counters[AURA_STAT_COUNT];
+    u64 hist[AURA_HIST_COUNT][AURA_HIST_BUCKETS];
+    u64 addr_xfers[AURA_STATS_ADDRESSES];
+    u64 addr_errors[AURA_STATS_ADDRESSES];
+};
+
+struct aura_stats {
+    struct aura_stats_cpu __percpu  *cpu;
+    struct dentry                   *dir;
+};
+
+error_t aura_stats_init (
+    void
+);
+
+void aura_stats_exit (
+    void
+);
+
+struct aura_stats *aura_stats_create (
+    void
+);
+
+void aura_stats_publish (
+    struct aura_stats *stats,
+    struct i2c_adapter *adapter
+);
+
+void aura_stats_destroy (
+    struct aura_stats *stats
+);
+
+static inline void aura_stats_add (
+    struct aura_stats *stats,
+    enum aura_stat stat,
+    u64 value
+){
+    if (stats)
+        this_cpu_add(stats->cpu->counters[stat], value);
+}
+
+static inline void aura_stats_inc (
+    struct aura_stats *stats,
+    enum aura_stat stat
+){
+    if (stats)
+        this_cpu_inc(stats->cpu->counters[stat]);
+}
+
+/* Records the time elapsed since @start */
+static inline void aura_stats_time (
+    struct aura_stats *stats,
+    enum aura_hist hist,
+    ktime_t start
+){
+    s64 us;
+    int bucket;
+
+    if (!stats)
+        return;
+
+    us = ktime_us_delta(ktime_get(), start);
+    bucket = us > 0 ? min_t(int, fls64(us), AURA_HIST_BUCKETS - 1) : 0;
+
+    this_cpu_inc(stats->cpu->hist[hist][bucket]);
+}
+
+static inline void aura_stats_addr (
+    struct aura_stats *stats,
+    uint16_t addr,
+    bool error
+){
+    if (!stats || addr >= AURA_STATS_ADDRESSES)
+        return;
+
+    this_cpu_inc(stats->cpu->addr_xfers[addr]);
+    if (error)
+        this_cpu_inc(stats->cpu->addr_errors[addr]);
+}
+
+/**
+ * aura_stats_xfer() - Accounts a whole transfer
+ * @stats: Adapter statistics
+ * @addr: Address of the first message
+ * @num: Number of messages, zero for SMBus commands
+ * @bytes: Payload bytes, only counted when @ret is not an error
+ * @ret: Result handed back to the i2c core
+ * @start: Time the transfer began
+ */
+static inline void aura_stats_xfer (
+    struct aura_stats *stats,
+    uint16_t addr,
+    int num,
+    u64 bytes,
+    int ret,
+    ktime_t start
+){
+    if (!stats)
+        return;
+
+    aura_stats_time(stats, AURA_HIST_XFER, start);
+    aura_stats_inc(stats, AURA_STAT_XFERS);
+    aura_stats_add(stats, AURA_STAT_MESSAGES, num);
+
+    if (ret < 0)
+        aura_stats_inc(stats, AURA_STAT_XFER_ERRORS);
+    else
+        aura_stats_add(stats, AURA_STAT_BYTES, bytes);
+
+    aura_stats_addr(stats, addr, ret < 0);
+}
+
+static inline u64 aura_stats_msg_bytes (
+    const struct i2c_msg *msgs,
+    int num
+){
+    u64 bytes = 0;
+    int i;
+
+    for (i = 0; i < num; i++)
+        bytes += msgs[i].len;
+
+    return bytes;
+}
+
+static inline u64 aura_stats_smbus_bytes (
+    int size,
+    const union i2c_smbus_data *data
+){
+    switch (size) {
+    case I2C_SMBUS_BYTE:
+    case I2C_SMBUS_BYTE_DATA:
+        return 1;
+    case I2C_SMBUS_WORD_DATA:
+        return 2;
+    case I2C_SMBUS_BLOCK_DATA:
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        return data ? data->block[0] : 0;
+    default:
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM aura_gpu
+
+#if !defined(_UAPI_AURA_GPU_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _UAPI_AURA_GPU_TRACE_H
+
+#include <linux/i2c.h>
+#include <linux/tracepoint.h>
+
+/*
+ * Each event sits behind its own static key, so when tracing is disabled
+ * a call site costs a single patched-out jump.
+ */
+
+DECLARE_EVENT_CLASS(aura_reg_access,
+    TP_PROTO(uint32_t reg, uint32_t value),
+    TP_ARGS(reg, value),
+    TP_STRUCT__entry(
+        __field(uint32_t, reg)
+        __field(uint32_t, value)
+    ),
+    TP_fast_assign(
+        __entry->reg = reg;
+        __entry->value = value;
+    ),
+    TP_printk("reg=0x%04x value=0x%08x", __entry->reg, __entry->value)
+);
+
+DEFINE_EVENT(aura_reg_access, aura_reg_read,
+    TP_PROTO(uint32_t reg, uint32_t value),
+    TP_ARGS(reg, value)
+);
+
+DEFINE_EVENT(aura_reg_access, aura_reg_write,
+    TP_PROTO(uint32_t reg, uint32_t value),
+    TP_ARGS(reg, value)
+);
+
+TRACE_EVENT(aura_i2c_xfer_start,
+    TP_PROTO(const struct i2c_adapter *adap, const struct i2c_msg *msgs, int num),
+    TP_ARGS(adap, msgs, num),
+    TP_STRUCT__entry(
+        __field(int, nr)
+        __field(int, num)
+        __field(uint16_t, addr)
+        __field(uint16_t, flags)
+        __field(uint16_t, len)
+    ),
+    TP_fast_assign(
+        __entry->nr = adap->nr;
+        __entry->num = num;
+        __entry->addr = num ? msgs[0].addr : 0;
+        __entry->flags = num ? msgs[0].flags : 0;
+        __entry->len = num ? msgs[0].len : 0;
+    ),
+    TP_printk("i2c-%d num=%d addr=0x%02x flags=0x%04x len=%u",
+        __entry->nr, __entry->num, __entry->addr, __entry->flags, __entry->len)
+);
+
+TRACE_EVENT(aura_i2c_xfer_end,
+    TP_PROTO(const struct i2c_adapter *adap, int num, int ret),
+    TP_ARGS(adap, num, ret),
+    TP_STRUCT__entry(
+        __field(int, nr)
+        __field(int, num)
+        __field(int, ret)
+    ),
+    TP_fast_assign(
+        __entry->nr = adap->nr;
+        __entry->num = num;
+        __entry->ret = ret;
+    ),
+    TP_printk("i2c-%d num=%d ret=%d", __entry->nr, __entry->num, __entry->ret)
+);
+
+TRACE_EVENT(aura_atom_table_enter,
+    TP_PROTO(int index, int ws, int ps),
+    TP_ARGS(index, ws, ps),
+    TP_STRUCT__entry(
+        __field(int, index)
+        __field(int, ws)
+        __field(int, ps)
+    ),
+    TP_fast_assign(
+        __entry->index = index;
+        __entry->ws = ws;
+        __entry->ps = ps;
+    ),
+    TP_printk("table=%d ws=%d ps=%d", __entry->index, __entry->ws, __entry->ps)
+);
+
+TRACE_EVENT(aura_atom_table_exit,
+    TP_PROTO(int index, int ret),
+    TP_ARGS(index, ret),
+    TP_STRUCT__entry(
+        __field(int, index)
+        __field(int, ret)
+    ),
+    TP_fast_assign(
+        __entry->index = index;
+        __entry->ret = ret;
+    ),
+    TP_printk("table=%d ret=%d", __entry->index, __entry->ret)
+);
+
+#endif /* _UAPI_AURA_GPU_TRACE_H */
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE aura-gpu-trace
+#include <trace/define_trace.h>
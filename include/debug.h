@@ -13,6 +13,14 @@
 
 #ifdef DEBUG
 #define _IS_NULL(_1) WARN(NULL == (_1), __LIGHTS_PREFIX "arg '%s' is NULL", #_1)
+#define IS_TRUE(_1) WARN(_1, __LIGHTS_PREFIX "expr '%s' is TRUE", #_1)
+#define IS_FALSE(_1) WARN(!(_1), "lights hw: expr '%s' is FALSE", #_1)
+#else
+/* Release builds keep the checks but drop the warnings */
+#define _IS_NULL(_1) unlikely(NULL == (_1))
+#define IS_TRUE(_1) unlikely(_1)
+#define IS_FALSE(_1) unlikely(!(_1))
+#endif
 #define _EXEC_1(X,_1) X(_1)
 #define _EXEC_2(X,_1,_2) (X(_1) || X(_2))
 #define _EXEC_3(X,_1,_2,_3) (X(_1) || X(_2) || X(_3))
@@ -20,13 +28,6 @@
 #define _EXEC(_0, _1, _2, _3, _4, N, ...) N
 #define IS_NULL(...) \
     _EXEC("dummy", ##__VA_ARGS__, _EXEC_4, _EXEC_3, _EXEC_2, _EXEC_1)(_IS_NULL, ##__VA_ARGS__)
-#define IS_TRUE(_1) WARN(_1, __LIGHTS_PREFIX "expr '%s' is TRUE", #_1)
-#define IS_FALSE(_1) WARN(!(_1), "lights hw: expr '%s' is FALSE", #_1)
-#else
-#define IS_NULL(...)
-#define IS_TRUE(_1)
-#define IS_FALSE(_1)
-#endif
 
 #define LIGHTS_ERR(_fmt, ...)({ \
     pr_err(__LIGHTS_PREFIX "[%s:%d] " _fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
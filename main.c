@@ -3,16 +3,24 @@
 #include <linux/pci.h>
 
 #include "debug.h"
-#include "aura-gpu-hw.h"
+#include "aura-gpu-backend.h"
+#include "aura-gpu-stats.h"
 
-static struct i2c_adapter *adapter = NULL;
+#define CREATE_TRACE_POINTS
+#include "aura-gpu-trace.h"
 
 static int __init aura_module_init (
     void
 ){
-    adapter = aura_i2c_bios_create();
-    if (IS_ERR_OR_NULL(adapter))
-        CLEAR_ERR(adapter);
+    error_t err;
+
+    err = aura_stats_init();
+    if (err)
+        return err;
+
+    err = aura_backends_create();
+    if (err)
+        AURA_DBG("No adapters created: %s", ERR_NAME(err));
 
     return 0;
 }
@@ -20,8 +28,9 @@ static int __init aura_module_init (
 static void __exit aura_module_exit (
     void
 ){
-    if (adapter)
-        aura_i2c_bios_destroy(adapter);
+    aura_backends_destroy();
+
+    aura_stats_exit();
 }
 
 module_init(aura_module_init);